@@ -0,0 +1,129 @@
+//
+// Memory benchmark of the version history: every change of a calendar creates a new version which shares all
+// untouched nodes with the previous one. For each change the nodes allocated by it are compared to a full copy of the list.
+// Usage: bench_versions [appointments...] (default: 1000 10000 100000)
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "libplanner.h"
+
+#define SAMPLES 1000 // changes measured per run, measuring takes time linear in the size of the calendar
+#define BATCH_SIZE 1000 // appointments inserted by a single plannerInsertMany() call
+
+//statistics of the measured changes of one run
+typedef struct
+{
+    size_t samples;
+    size_t createdSum, createdMax;
+    size_t copySum; // nodes a full copy of the list would have allocated for the same changes
+    size_t nodeSize;
+} Result;
+
+void measure(Calendar *calendar, Result *result);
+void printResult(const char *operation, size_t items, Result *result);
+void shuffle(PlannerAppointment *appointments, size_t count);
+void benchmark(size_t count);
+
+//record the nodes allocated by the last change of 'calendar'
+void measure(Calendar *calendar, Result *result){
+    PlannerVersionStats stats;
+    plannerVersionStats(calendar, &stats);
+    result->samples++;
+    result->createdSum += stats.created;
+    if(stats.created > result->createdMax){
+        result->createdMax = stats.created;
+    }
+    result->copySum += stats.nodes;
+    result->nodeSize = stats.nodeSize;
+}
+
+//print a single line of the result table
+void printResult(const char *operation, size_t items, Result *result){
+    double created = (double) result->createdSum / result->samples;
+    double copy = (double) result->copySum / result->samples;
+    printf("%-10s %10zu %10.1f %10zu %12.1f %12.0f %14.0f %9.3f%%\n", operation, items, created, result->createdMax,
+           copy, created * result->nodeSize, copy * result->nodeSize, copy > 0 ? 100.0 * created / copy : 0.0);
+}
+
+//put the appointments into a random order
+void shuffle(PlannerAppointment *appointments, size_t count){
+    for (size_t i = count; i > 1; --i) {
+        size_t j = (size_t) rand() % i;
+        PlannerAppointment tmp = appointments[i-1];
+        appointments[i-1] = appointments[j];
+        appointments[j] = tmp;
+    }
+}
+
+//insert 'count' appointments one at a time, delete them one at a time and insert them in batches.
+//every SAMPLES-th part of the changes is measured
+void benchmark(size_t count){
+    PlannerAppointment *appointments = malloc(count * sizeof(PlannerAppointment));
+    Calendar *calendar = plannerOpen(NULL, 0, NULL);
+    if(appointments == NULL || calendar == NULL){
+        fprintf(stderr, "FATAL ERROR: memory exhausted, malloc() failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    time_t start = time(NULL) + 86400;
+    for (size_t i = 0; i < count; ++i) {
+        appointments[i].start = start + (time_t) i * 60;
+        snprintf(appointments[i].description, PLANNER_DESCRIPTION_SIZE, "appointment %zu", i);
+    }
+    shuffle(appointments, count);
+    size_t step = count > SAMPLES ? count / SAMPLES : 1;
+
+    Result result = {0};
+    for (size_t i = 0; i < count; ++i) {
+        if(plannerInsertMany(calendar, &appointments[i], 1) != 1){
+            fprintf(stderr, "FATAL ERROR: memory exhausted, malloc() failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        if(i % step == 0){
+            measure(calendar, &result);
+        }
+    }
+    printResult("insert", count, &result);
+
+    shuffle(appointments, count);
+    result = (Result) {0};
+    for (size_t i = 0; i < count; ++i) {
+        plannerDeleteMany(calendar, &appointments[i], 1);
+        if(i % step == 0){
+            measure(calendar, &result);
+        }
+    }
+    printResult("delete", count, &result);
+
+    result = (Result) {0};
+    for (size_t i = 0; i < count; i += BATCH_SIZE) {
+        size_t batch = count-i < BATCH_SIZE ? count-i : BATCH_SIZE;
+        plannerInsertMany(calendar, &appointments[i], batch);
+        measure(calendar, &result);
+    }
+    printResult("batch", count, &result);
+
+    plannerClose(calendar);
+    free(appointments);
+}
+
+int main(int argc, char** argv) {
+    srand(1);
+    printf("nodes and bytes allocated per change (version) compared to a full copy of the list\n");
+    printf("%-10s %10s %10s %10s %12s %12s %14s %10s\n", "operation", "items", "nodes/chg", "max", "copy nodes",
+           "bytes/chg", "copy bytes", "overhead");
+    if(argc < 2){
+        benchmark(1000);
+        benchmark(10000);
+        benchmark(100000);
+    }
+    for (int i = 1; i < argc; ++i) {
+        size_t count = strtoul(argv[i], NULL, 10);
+        if(count == 0){
+            fprintf(stderr, "ERROR: %s is not a positive number of appointments\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        benchmark(count);
+    }
+    return 0;
+}
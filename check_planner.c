@@ -0,0 +1,232 @@
+//
+// Randomized comparison of the two modes of libplanner: the same list file is opened in memory and in external-memory
+// mode, then both calendars get the same random inserts, deletes, deleteall, imports, undo and redo. after every change
+// the listings (paged and by range) have to match, at the end the saved files as well. descriptions of the longest
+// allowed length are part of the list file, the inserts and the imports.
+// Usage: check_planner [seeds...] (default: 1 to 10), returns EXIT_FAILURE at the first difference
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include "libplanner.h"
+
+#define ROWS 2000 // appointments of the list file
+#define STEPS 300 // random changes per seed
+#define MEMORY_LIMIT 65536 // small enough that the list file and the imports are spread over many runs
+#define PAGE_SIZE 293 // page size of the paged listing, not a divisor of any other size used here
+#define MAX_APPOINTMENTS 100000
+#define SPAN 20000 // the start times are within SPAN seconds, so many of them are identical
+
+static PlannerAppointment listed[2][MAX_APPOINTMENTS];
+
+void randomDescription(char *description);
+size_t listAll(Calendar *calendar, PlannerAppointment *out);
+void compare(Calendar *memory, Calendar *external, int seed, int step);
+void writeListFile(const char *filename, time_t base);
+void writeIcsFile(const char *filename, time_t base, int events);
+bool sameFiles(const char *a, const char *b);
+void fail(int seed, int step, const char *reason);
+void check(int seed);
+
+//random description from a few common ones, some of them as long as a row of the list file allows
+void randomDescription(char *description){
+    int kind = rand() % 4;
+    if(kind == 0){
+        memset(description, 'a' + rand() % 26, PLANNER_DESCRIPTION_SIZE-1);
+        description[PLANNER_DESCRIPTION_SIZE-1] = '\0';
+    }else{
+        snprintf(description, PLANNER_DESCRIPTION_SIZE, "appointment %d", rand() % 5);
+    }
+}
+
+//list every appointment of 'calendar' page by page
+size_t listAll(Calendar *calendar, PlannerAppointment *out){
+    size_t count = 0, n;
+    const PlannerAppointment *after = NULL;
+    while(count < MAX_APPOINTMENTS &&
+          (n = plannerQueryRange(calendar, LONG_MIN, LONG_MAX, after, out+count, PAGE_SIZE)) > 0){
+        count += n;
+        after = &out[count-1];
+    }
+    return count;
+}
+
+//compare the full listing and a range query of both calendars
+void compare(Calendar *memory, Calendar *external, int seed, int step){
+    size_t n = listAll(memory, listed[0]);
+    if(n != listAll(external, listed[1])){
+        fail(seed, step, "different number of appointments");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if(listed[0][i].start != listed[1][i].start || strcmp(listed[0][i].description, listed[1][i].description)){
+            fail(seed, step, "different appointments");
+        }
+    }
+    if(n == 0){
+        return;
+    }
+    time_t from = listed[0][n/2].start;
+    size_t m = plannerQueryRange(memory, from, from + SPAN/10, NULL, listed[0], PAGE_SIZE);
+    if(m != plannerQueryRange(external, from, from + SPAN/10, NULL, listed[1], PAGE_SIZE)){
+        fail(seed, step, "different number of appointments in a range");
+    }
+    for (size_t i = 0; i < m; ++i) {
+        if(listed[0][i].start != listed[1][i].start || strcmp(listed[0][i].description, listed[1][i].description)){
+            fail(seed, step, "different appointments in a range");
+        }
+    }
+}
+
+//list file with ROWS appointments in random order
+void writeListFile(const char *filename, time_t base){
+    FILE *file = fopen(filename, "w");
+    if(file == NULL){
+        perror(filename);
+        exit(EXIT_FAILURE);
+    }
+    char description[PLANNER_DESCRIPTION_SIZE];
+    for (int i = 0; i < ROWS; ++i) {
+        randomDescription(description);
+        fprintf(file, "%ld,%s\n", base + rand() % SPAN, description);
+    }
+    fclose(file);
+}
+
+//iCalendar file with 'events' VEVENTs in random order
+void writeIcsFile(const char *filename, time_t base, int events){
+    FILE *file = fopen(filename, "w");
+    if(file == NULL){
+        perror(filename);
+        exit(EXIT_FAILURE);
+    }
+    char description[PLANNER_DESCRIPTION_SIZE];
+    fprintf(file, "BEGIN:VCALENDAR\r\n");
+    for (int i = 0; i < events; ++i) {
+        time_t start = base + rand() % SPAN;
+        char dtstart[32];
+        strftime(dtstart, sizeof(dtstart), "%Y%m%dT%H%M%SZ", gmtime(&start));
+        randomDescription(description);
+        //long lines are valid as well, readers have to unfold them but writers only should fold them
+        fprintf(file, "BEGIN:VEVENT\r\nDTSTART:%s\r\nSUMMARY:%s\r\nEND:VEVENT\r\n", dtstart, description);
+    }
+    fprintf(file, "END:VCALENDAR\r\n");
+    fclose(file);
+}
+
+//check whether the files 'a' and 'b' have the same content, missing files count as empty
+bool sameFiles(const char *a, const char *b){
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int ca = EOF, cb = EOF;
+    do{
+        ca = fa != NULL ? fgetc(fa) : EOF;
+        cb = fb != NULL ? fgetc(fb) : EOF;
+    }while(ca == cb && ca != EOF);
+    if(fa != NULL){
+        fclose(fa);
+    }
+    if(fb != NULL){
+        fclose(fb);
+    }
+    return ca == cb;
+}
+
+void fail(int seed, int step, const char *reason){
+    fprintf(stderr, "FAILED: seed %d, step %d: %s\n", seed, step, reason);
+    exit(EXIT_FAILURE);
+}
+
+//run STEPS random changes with the seed 'seed' on both modes
+void check(int seed){
+    srand(seed);
+    char listFile[] = "/tmp/check_planner_XXXXXX", icsFile[] = "/tmp/check_planner_XXXXXX";
+    char savedMemory[] = "/tmp/check_planner_XXXXXX", savedExternal[] = "/tmp/check_planner_XXXXXX";
+    char *files[] = {listFile, icsFile, savedMemory, savedExternal};
+    for (int i = 0; i < 4; ++i) {
+        int fd = mkstemp(files[i]);
+        if(fd == -1){
+            perror("mkstemp");
+            exit(EXIT_FAILURE);
+        }
+        close(fd);
+    }
+    time_t base = time(NULL) + 86400;
+    writeListFile(listFile, base);
+
+    Calendar *memory = plannerOpen(listFile, 0, NULL);
+    Calendar *external = plannerOpen(listFile, MEMORY_LIMIT, NULL);
+    if(memory == NULL || external == NULL || !plannerIsExternal(external)){
+        fail(seed, -1, "couldn't open the list file");
+    }
+    compare(memory, external, seed, -1);
+
+    PlannerAppointment batch[8];
+    for (int step = 0; step < STEPS; ++step) {
+        int operation = rand() % 20;
+        if(operation < 6){
+            int count = rand() % 8 + 1;
+            for (int i = 0; i < count; ++i) {
+                batch[i].start = base + rand() % SPAN;
+                randomDescription(batch[i].description);
+            }
+            if(plannerInsertMany(memory, batch, count) != plannerInsertMany(external, batch, count)){
+                fail(seed, step, "different number of inserted appointments");
+            }
+        }else if(operation < 12){
+            size_t n = listAll(memory, listed[0]);
+            int count = rand() % 8 + 1;
+            for (int i = 0; i < count && n > 0; ++i) {
+                batch[i] = listed[0][rand() % n];
+            }
+            if(n > 0 && plannerDeleteMany(memory, batch, count) != plannerDeleteMany(external, batch, count)){
+                fail(seed, step, "different number of deleted appointments");
+            }
+        }else if(operation == 12){
+            if(rand() % 4 == 0 && plannerClear(memory) != plannerClear(external)){
+                fail(seed, step, "deleteall failed in one mode");
+            }
+        }else if(operation == 13){
+            writeIcsFile(icsFile, base, rand() % 300);
+            PlannerStats memoryStats, externalStats;
+            if(plannerImportIcs(memory, icsFile, &memoryStats) != plannerImportIcs(external, icsFile, &externalStats)
+               || memoryStats.loaded != externalStats.loaded){
+                fail(seed, step, "different number of imported appointments");
+            }
+        }else if(operation < 17){
+            if(plannerUndo(memory) != plannerUndo(external)){
+                fail(seed, step, "undo failed in one mode");
+            }
+        }else{
+            if(plannerRedo(memory) != plannerRedo(external)){
+                fail(seed, step, "redo failed in one mode");
+            }
+        }
+        compare(memory, external, seed, step);
+    }
+
+    if(!plannerSave(memory, savedMemory) || !plannerSave(external, savedExternal)
+       || !sameFiles(savedMemory, savedExternal)){
+        fail(seed, STEPS, "different saved files");
+    }
+    plannerClose(memory);
+    plannerClose(external);
+    for (int i = 0; i < 4; ++i) {
+        remove(files[i]);
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2){
+        for (int seed = 1; seed <= 10; ++seed) {
+            check(seed);
+        }
+    }
+    for (int i = 1; i < argc; ++i) {
+        check(atoi(argv[i]));
+    }
+    printf("check_planner: both modes agree\n");
+    return 0;
+}
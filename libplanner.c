@@ -0,0 +1,1824 @@
+//
+// Implementation of libplanner.h: a persistent AVL tree holding the appointments of a calendar, the list file format
+// written by saveList(), iCalendar import/export and the external-memory mode.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <strings.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "libplanner.h"
+
+#define LINE_LENGTH (PLANNER_DESCRIPTION_SIZE+22) // longest row of the list file: "%ld,", description, '\n' and '\0'
+#define RUN_LINE_LENGTH (PLANNER_DESCRIPTION_SIZE+43) // longest row of a run: "%ld,%lu,", description, '\n' and '\0'
+#define MAX_HISTORY 100   // number of versions kept for undo/redo, the oldest one is dropped first
+#define MAX_TREE_HEIGHT 64 // an AVL tree with 2^44 nodes is still lower than this
+#define ICS_LINE_LENGTH 1024 // unfolded iCalendar content lines are truncated after this many characters
+#define ICS_CHUNK_SIZE 65536 // size of the read buffer used while importing iCalendar files
+#define INDEX_SUFFIX ".idx" // the sparse offset index of a list file is stored next to it
+#define INDEX_PAGE_SIZE 4096 // the index holds one record for every page of the list file
+#define INDEX_RECORD_LENGTH 42 // "%020ld %020ld\n"
+#define MAX_RUNS 32 // runs kept on disk by the external-memory mode, once reached they are merged into one
+#define MERGE_FACTOR 4 // number of runs of the same level which are merged into a single run of the next level
+#define MIN_RUN_BUFFER 4096 // smallest stdio buffer used for a run
+
+//entries of the tree of the external-memory mode can also hide rows kept on disk in the runs (see cursorNext())
+typedef enum
+{
+    APPOINTMENT,
+    TOMBSTONE, // the run row with the same start time and id is deleted
+    CLEARED,   // every run row with a smaller id is deleted (deleteall), always the first entry of the tree
+    IMPORTED   // the run rows of the import with this id are visible (see RunStore.imports)
+} EntryKind;
+
+//appointments are immutable once created and shared between every version of the list that contains them
+typedef struct
+{
+    time_t start;
+    char *description;
+    unsigned long id; // breaks ties between appointments with identical start times
+    int refs;
+    EntryKind kind;
+} Appointment;
+
+//node of a persistent AVL tree ordered by (start, id). nodes are never modified after creation,
+//every mutation copies the path from the root to the changed node and shares all other subtrees
+typedef struct Node
+{
+    Appointment *appointment;
+    struct Node *left, *right;
+    int height;
+    int refs;
+} Node;
+
+//row of the sort buffer used by the external-memory mode
+typedef struct
+{
+    time_t start;
+    unsigned long id;
+    size_t offset; // position of the description in the sort buffer
+} Record;
+
+//state of the external-memory mode (see readList()): appointments loaded from the list file are kept on disk
+//in runs sorted by start time and id ("start,id,description" lines) and only a fixed amount of memory is used for buffers.
+//rows are never removed from a run since older versions of the list may still show them, deletions are recorded in the tree
+typedef struct
+{
+    char *sortBuffer;
+    size_t sortSize, recordCount, textUsed;
+    char *pool; // stdio buffers of the runs, one slot of 'bufferSize' bytes per run
+    size_t bufferSize;
+    bool slotUsed[MAX_RUNS+1]; // one extra slot for the run created while merging
+    FILE *runs[MAX_RUNS]; // oldest run first, levels never increase from one run to the next
+    int runSlots[MAX_RUNS];
+    int runLevels[MAX_RUNS]; // a run of level l holds about MERGE_FACTOR^l spilled sort buffers
+    unsigned long runMaxIds[MAX_RUNS]; // largest id of each run, runs hidden by a CLEARED entry are skipped
+    int runCount;
+    unsigned long *imports; // ascending id of each import, its rows have larger ids than it and smaller ones than the next import
+    size_t importCount, importCapacity;
+} RunStore;
+
+//every version of the list is the root of its own tree, versions[current] is the visible one.
+//versions after 'current' can be restored with redoList() until the next mutation discards them
+typedef struct
+{
+    Node **versions;
+    size_t current, count;
+    unsigned long nextId;
+    RunStore *store; // NULL unless the external-memory mode is used, the tree then only holds new appointments and
+                     // the entries hiding deleted rows of the runs
+} List;
+
+//in-order cursor over a tree, the stack holds the nodes whose appointment has not been returned yet
+typedef struct
+{
+    Node *stack[MAX_TREE_HEIGHT];
+    int depth;
+} Iterator;
+
+//cursor over a single run
+typedef struct
+{
+    FILE *file;
+    char line[RUN_LINE_LENGTH];
+    Appointment row;
+    bool valid;
+} RunCursor;
+
+//cursor merging a tree and the runs of the external-memory mode into one sequence sorted by start time
+typedef struct
+{
+    Iterator tree;
+    Appointment *treeNext;
+    RunCursor runs[MAX_RUNS];
+    int runCount;
+    unsigned long hiddenBelow; // run rows with a smaller id were deleted by a CLEARED entry
+    RunStore *store; // NULL if the rows of every import are visible
+    Node *root;
+    Appointment current;
+    char description[PLANNER_DESCRIPTION_SIZE];
+} Cursor;
+
+static List createList();
+static bool clearList(List *list);
+static void freeList(List *list);
+static bool undoList(List *list);
+static bool redoList(List *list);
+static Node *snapshotList(List *list);
+static bool saveList(RunStore *store, Node *root, const char *filename);
+static List readList(const char *filename, size_t memoryLimit, PlannerStats *stats);
+static bool importIcs(List *list, const char *filename, PlannerStats *stats);
+static bool exportIcs(RunStore *store, Node *root, const char *filename);
+static char *indexFilename(const char *filename);
+static void writeIndexEntry(FILE *index, long *lastPage, long offset, time_t start);
+static long findFirstLine(FILE *file, long lo, long hi, time_t from);
+static RunStore *createStore(size_t memoryLimit);
+static void freeStore(RunStore *store);
+static bool storeAdd(RunStore *store, time_t start, unsigned long id, const char *description);
+static bool spillRun(RunStore *store);
+static bool storeAddImport(RunStore *store, unsigned long id);
+static void cursorSeek(Cursor *cursor, RunStore *store, Node *root, time_t from);
+static void cursorSeekRuns(Cursor *cursor, FILE **runs, int count, time_t from);
+static Appointment *cursorFind(Cursor *cursor, RunStore *store, Node *root, time_t start, const char *description);
+static Appointment *cursorNext(Cursor *cursor);
+static bool rowVisible(Cursor *cursor, Appointment *row);
+static bool treeContains(Node *root, Appointment *key);
+static Appointment* newAppointment(time_t start, const char *description, unsigned long id);
+static void releaseAppointment(Appointment *appointment);
+static Node *retainNode(Node *node);
+static void releaseNode(Node *node);
+static void iterSeek(Iterator *it, Node *root, time_t from);
+static Appointment *iterNext(Iterator *it);
+static void toLowercase(char* str);
+
+//create a new appointment starting at the given time 'start'
+//allocate memory for the structure & description usinc malloc() and return a pointer to said structure
+//the appointment starts with a single reference which belongs to the caller, NULL is returned if malloc() failed
+static Appointment* newAppointment(time_t start, const char *description, unsigned long id){
+    Appointment *appointment = (Appointment*) malloc(sizeof(Appointment));
+    if(appointment == NULL){
+        return NULL;
+    }
+    appointment->start = start;
+    appointment->id = id;
+    appointment->refs = 1;
+    appointment->kind = APPOINTMENT;
+    appointment->description = malloc(strlen(description)+1);
+    if(appointment->description == NULL){
+        free(appointment);
+        return NULL;
+    }
+    strncpy(appointment->description, description, strlen(description)+1);
+
+    return appointment;
+}
+
+//drop one reference to 'appointment' and free it once no version of the list uses it anymore
+static void releaseAppointment(Appointment *appointment){
+    if(appointment != NULL && --appointment->refs == 0){
+        free(appointment->description);
+        free(appointment);
+    }
+}
+
+//order appointments by start time, appointments starting at the same time keep their insertion order
+static int compareAppointments(Appointment *a, Appointment *b){
+    if(a->start != b->start){
+        return a->start < b->start ? -1 : 1;
+    }
+    if(a->id != b->id){
+        return a->id < b->id ? -1 : 1;
+    }
+    return 0;
+}
+
+static int nodeHeight(Node *node){
+    return node == NULL ? 0 : node->height;
+}
+
+static Node *retainNode(Node *node){
+    if(node != NULL){
+        node->refs++;
+    }
+    return node;
+}
+
+//drop one reference to 'node', once unused the node releases its children and appointment as well
+static void releaseNode(Node *node){
+    if(node != NULL && --node->refs == 0){
+        releaseNode(node->left);
+        releaseNode(node->right);
+        releaseAppointment(node->appointment);
+        free(node);
+    }
+}
+
+//create a new node holding 'appointment', the references to 'left' and 'right' are taken over by the new node.
+//if malloc() fails, 'ok' is set to false, 'left' and 'right' are released and NULL is returned. the tree built by the
+//caller is incomplete then but its reference counts stay consistent, so it can simply be released
+static Node *makeNode(Appointment *appointment, Node *left, Node *right, bool *ok){
+    Node *node = (Node*) malloc(sizeof(Node));
+    if(node == NULL){
+        *ok = false;
+        releaseNode(left);
+        releaseNode(right);
+        return NULL;
+    }
+    appointment->refs++;
+    node->appointment = appointment;
+    node->left = left;
+    node->right = right;
+    node->refs = 1;
+    int hl = nodeHeight(left), hr = nodeHeight(right);
+    node->height = (hl > hr ? hl : hr) + 1;
+    return node;
+}
+
+//like makeNode() but restores the AVL property if the heights of 'left' and 'right' differ by more than one.
+//rotations create new nodes instead of modifying 'left' or 'right', since those might be shared with older versions
+static Node *balanceNode(Appointment *appointment, Node *left, Node *right, bool *ok){
+    int hl = nodeHeight(left), hr = nodeHeight(right);
+    Node *result;
+
+    if(hl > hr+1){
+        if(nodeHeight(left->left) >= nodeHeight(left->right)){
+            result = makeNode(left->appointment, retainNode(left->left),
+                              makeNode(appointment, retainNode(left->right), right, ok), ok);
+        }else{
+            Node *lr = left->right;
+            result = makeNode(lr->appointment,
+                              makeNode(left->appointment, retainNode(left->left), retainNode(lr->left), ok),
+                              makeNode(appointment, retainNode(lr->right), right, ok), ok);
+        }
+        releaseNode(left);
+    }else if(hr > hl+1){
+        if(nodeHeight(right->right) >= nodeHeight(right->left)){
+            result = makeNode(right->appointment,
+                              makeNode(appointment, left, retainNode(right->left), ok), retainNode(right->right), ok);
+        }else{
+            Node *rl = right->left;
+            result = makeNode(rl->appointment,
+                              makeNode(appointment, left, retainNode(rl->left), ok),
+                              makeNode(right->appointment, retainNode(rl->right), retainNode(right->right), ok), ok);
+        }
+        releaseNode(right);
+    }else{
+        result = makeNode(appointment, left, right, ok);
+    }
+    return result;
+}
+
+//return a new version of the tree 'node' which additionally contains 'appointment'.
+//'ok' is set to false if memory ran out, the returned tree has to be released then
+static Node *treeInsert(Node *node, Appointment *appointment, bool *ok){
+    if(node == NULL){
+        return makeNode(appointment, NULL, NULL, ok);
+    }
+    if(compareAppointments(appointment, node->appointment) < 0){
+        return balanceNode(node->appointment, treeInsert(node->left, appointment, ok), retainNode(node->right), ok);
+    }
+    return balanceNode(node->appointment, retainNode(node->left), treeInsert(node->right, appointment, ok), ok);
+}
+
+//return a new version of the tree 'node' without its smallest appointment
+static Node *treeRemoveMin(Node *node, bool *ok){
+    if(node->left == NULL){
+        return retainNode(node->right);
+    }
+    return balanceNode(node->appointment, treeRemoveMin(node->left, ok), retainNode(node->right), ok);
+}
+
+//return a new version of the tree 'node' without 'target', 'removed' is set to true if 'target' was part of the tree
+//if 'target' is not found, the unchanged tree is returned instead of a copy. 'ok' is set to false if memory ran out
+static Node *treeRemove(Node *node, Appointment *target, bool *removed, bool *ok){
+    if(node == NULL){
+        return NULL;
+    }
+    int cmp = compareAppointments(target, node->appointment);
+    if(cmp == 0){
+        *removed = true;
+        if(node->left == NULL){
+            return retainNode(node->right);
+        }
+        if(node->right == NULL){
+            return retainNode(node->left);
+        }
+        Node *min = node->right;
+        while(min->left != NULL){
+            min = min->left;
+        }
+        return balanceNode(min->appointment, retainNode(node->left), treeRemoveMin(node->right, ok), ok);
+    }
+
+    Node *child = treeRemove(cmp < 0 ? node->left : node->right, target, removed, ok);
+    if(!*removed){
+        releaseNode(child);
+        return retainNode(node);
+    }
+    if(cmp < 0){
+        return balanceNode(node->appointment, child, retainNode(node->right), ok);
+    }
+    return balanceNode(node->appointment, retainNode(node->left), child, ok);
+}
+
+//position 'it' in front of the first appointment in 'root' which starts at or after 'from'
+static void iterSeek(Iterator *it, Node *root, time_t from){
+    it->depth = 0;
+    Node *node = root;
+    while(node != NULL){
+        if(node->appointment->start >= from){
+            it->stack[it->depth++] = node;
+            node = node->left;
+        }else{
+            node = node->right;
+        }
+    }
+}
+
+//return the next appointment in ascending order or NULL once the end of the tree has been reached
+static Appointment *iterNext(Iterator *it){
+    if(it->depth == 0){
+        return NULL;
+    }
+    Node *node = it->stack[--it->depth];
+    Node *next = node->right;
+    while(next != NULL){
+        it->stack[it->depth++] = next;
+        next = next->left;
+    }
+    return node->appointment;
+}
+
+//create & return an empty list with a single (empty) version, 'versions' is NULL if malloc() failed
+static List createList(){
+    List list;
+    list.versions = (Node**) malloc(MAX_HISTORY * sizeof(Node*));
+    list.store = NULL;
+    if(list.versions == NULL){
+        return list;
+    }
+    list.versions[0] = NULL;
+    list.current = 0;
+    list.count = 1;
+    list.nextId = 0;
+
+    return list;
+}
+
+//make 'root' the visible version of 'list', the reference to 'root' is taken over by the list.
+//versions which could have been restored with redoList() are discarded, if the history is full the oldest version is dropped
+static void commitVersion(List *list, Node *root){
+    while(list->count > list->current+1){
+        releaseNode(list->versions[--list->count]);
+    }
+    if(list->count == MAX_HISTORY){
+        releaseNode(list->versions[0]);
+        memmove(list->versions, list->versions+1, (MAX_HISTORY-1) * sizeof(Node*));
+        list->count--;
+    }
+    list->versions[list->count] = root;
+    list->current = list->count++;
+}
+
+//return a reference to the visible version of 'list'. the snapshot stays unchanged while 'list' is modified
+//and has to be returned with releaseNode()
+static Node *snapshotList(List *list){
+    return retainNode(list->versions[list->current]);
+}
+
+//go back to the previous version of 'list', returns false if there is none
+static bool undoList(List *list){
+    if(list->current == 0){
+        return false;
+    }
+    list->current--;
+    return true;
+}
+
+//restore the version that was visible before the last call to undoList(), returns false if there is none
+static bool redoList(List *list){
+    if(list->current+1 >= list->count){
+        return false;
+    }
+    list->current++;
+    return true;
+}
+
+// Function to save the tree 'root' and the runs of 'store' (may be NULL) to a CSV file
+// rows are written in ascending order of their start time, plannerQueryFileRange() relies on this.
+// if the file has a sparse offset index (see plannerBuildIndex()), the index is rewritten as well.
+// in external-memory mode the runs are merged into the file here. returns false if the file couldn't be written
+static bool saveList(RunStore *store, Node *root, const char *filename){
+    Cursor cursor;
+    cursorSeek(&cursor, store, root, LONG_MIN);
+    Appointment *appointment = cursorNext(&cursor);
+    bool ok = true;
+    if(appointment != NULL){
+        FILE *file = fopen(filename, "w");
+        if(file == NULL){
+            return false;
+        }
+
+        struct stat indexStat;
+        FILE *index = NULL;
+        char *name = indexFilename(filename);
+        if(name != NULL && stat(name, &indexStat) == 0){
+            index = fopen(name, "w");
+        }
+        free(name);
+        long lastPage = -1;
+
+        for (; appointment != NULL; appointment = cursorNext(&cursor)){
+            if(index != NULL){
+                writeIndexEntry(index, &lastPage, ftell(file), appointment->start);
+            }
+            //y2k38-bug possible depending on data model and size of time_t.. %ld should be replaced with %lld
+            fprintf(file, "%ld,%s\n", appointment->start, appointment->description);
+        }
+        ok = !ferror(file);
+        if(fclose(file) != 0){
+            ok = false;
+        }
+        if(index != NULL){
+            fclose(index); // closed after the list file, an index older than its list file is ignored
+        }
+    }
+    return ok;
+}
+
+//insert a new appointment into the tree 'root' without recording a version in 'list'.
+//used while loading many appointments at once, which should become a single version: the intermediate tree is released right away
+//returns false if memory ran out, 'root' is unchanged then
+static bool bulkInsert(List *list, Node **root, time_t start, const char *description){
+    Appointment *appointment = newAppointment(start, description, list->nextId++);
+    if(appointment == NULL){
+        return false;
+    }
+    bool ok = true;
+    Node *next = treeInsert(*root, appointment, &ok);
+    releaseAppointment(appointment);
+    if(!ok){
+        releaseNode(next);
+        return false;
+    }
+    releaseNode(*root);
+    *root = next;
+    return true;
+}
+
+// Function to read the appointment list from file, the result of loading is stored in 'stats'
+// if 'memoryLimit' is not 0, the external-memory mode is used: appointments are not loaded into the tree but sorted
+// into runs on disk, using at most 'memoryLimit' bytes for buffers.
+// 'versions' of the returned list is NULL if memory ran out or a run couldn't be written
+static List readList(const char *filename, size_t memoryLimit, PlannerStats *stats){
+    memset(stats, 0, sizeof(PlannerStats));
+    List list = createList();
+    if(list.versions == NULL){
+        return list;
+    }
+    if(memoryLimit > 0){
+        list.store = createStore(memoryLimit);
+        if(list.store == NULL){
+            freeList(&list);
+            return list;
+        }
+    }
+    time_t curr_time = time(NULL);
+
+    FILE *file = fopen(filename, "r");
+
+    if(file != NULL){
+        Node *root = NULL;
+        bool ok = true;
+        char line[LINE_LENGTH];
+        while (ok && fgets(line, sizeof(line), file) != NULL){
+            long start;
+            char description[LINE_LENGTH];
+            if(strchr(line, '\n') == NULL && !feof(file)){
+                //the row is longer than any row saveList() writes, drop the whole row instead of reading its rest as another one
+                int c;
+                while((c = getc(file)) != '\n' && c != EOF){}
+                stats->invalid++;
+                continue;
+            }
+            //y2k38-bug possible depending on data model and size of time_t %ld should be replaced with %lld(+ l.150: long long start;)
+            if(sscanf(line, "%ld,%[^\n]", &start, description) == 2 && strlen(description) < PLANNER_DESCRIPTION_SIZE){ // Check if sscanf was able to read both parameters from the line, ignore the line otherwise
+                if(start > curr_time){
+                    if(list.store != NULL){
+                        ok = storeAdd(list.store, start, list.nextId++, description);
+                    }else{
+                        ok = bulkInsert(&list, &root, start, description);
+                    }
+                    stats->loaded++;
+                }else{
+                    stats->expired++;
+                }
+            }else{
+                stats->invalid++;
+            }
+        }
+        list.versions[0] = root;
+        if(ok && list.store != NULL){
+            ok = spillRun(list.store);
+        }
+
+        fclose(file);
+        if(!ok){
+            freeList(&list);
+        }
+    }else{
+        stats->unreadable = true;
+    }
+
+    return list;
+}
+
+//buffered reader for iCalendar files. memory use is bounded by the chunk and line buffers regardless of file size
+typedef struct
+{
+    FILE *file;
+    char chunk[ICS_CHUNK_SIZE];
+    size_t pos, len;
+} IcsReader;
+
+//return the next byte of the file or EOF, refilling the chunk buffer when necessary
+static int icsGetc(IcsReader *reader){
+    if(reader->pos == reader->len){
+        reader->len = fread(reader->chunk, 1, ICS_CHUNK_SIZE, reader->file);
+        reader->pos = 0;
+        if(reader->len == 0){
+            return EOF;
+        }
+    }
+    return (unsigned char) reader->chunk[reader->pos++];
+}
+
+//read the next content line into 'buffer' and undo line folding (RFC 5545 3.1): a line break followed by a
+//space or tab continues the previous line. characters beyond 'len'-1 are dropped, returns false at end of file
+static bool readIcsLine(IcsReader *reader, char *buffer, size_t len){
+    size_t n = 0;
+    int c;
+    while ((c = icsGetc(reader)) != EOF){
+        if(c == '\r'){
+            continue;
+        }
+        if(c == '\n'){
+            int next = icsGetc(reader);
+            if(next == ' ' || next == '\t'){
+                continue;
+            }
+            if(next != EOF){
+                reader->pos--; // the byte is still in the chunk buffer, it starts the next line
+            }
+            break;
+        }
+        if(n < len-1){
+            buffer[n++] = (char) c;
+        }
+    }
+    buffer[n] = '\0';
+    return c != EOF || n > 0;
+}
+
+//convert a UTC calendar time to unix time without depending on the local time zone
+static time_t utcToEpoch(int year, int month, int day, int hour, int min, int sec){
+    //days since 1970-01-01 in the proleptic gregorian calendar
+    int y = year - (month <= 2);
+    long era = (y >= 0 ? y : y-399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+    long days = era * 146097 + doe - 719468;
+    return (time_t) days * 86400 + hour * 3600 + min * 60 + sec;
+}
+
+//number of days in 'month' (1-12) of 'year' in the gregorian calendar
+static int daysInMonth(int year, int month){
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return days[month-1] + (month == 2 && leap);
+}
+
+//parse a DATE (yyyymmdd) or DATE-TIME (yyyymmddThhmmss[Z]) value. values with 'Z' or with 'utc' set are UTC,
+//all others are treated as local time. returns -1 if the value couldn't be parsed or a field is out of range
+static time_t parseIcsTime(const char *value, bool utc){
+    size_t len = strlen(value);
+    bool dateOnly = len == 8;
+    if(!dateOnly && len != 15 && !(len == 16 && value[15] == 'Z')){
+        return -1;
+    }
+    for (size_t i = 0; i < (dateOnly ? 8 : 15); ++i) {
+        if(i == 8 ? value[i] != 'T' : !isdigit((unsigned char) value[i])){
+            return -1;
+        }
+    }
+    int year, month, day, hour = 0, min = 0, sec = 0;
+    sscanf(value, "%4d%2d%2d", &year, &month, &day);
+    if(!dateOnly){
+        sscanf(value+9, "%2d%2d%2d", &hour, &min, &sec);
+    }
+    //mktime() would silently normalize out-of-range fields (e.g. month 13), a leap second (60) is allowed
+    if(month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || min > 59 || sec > 60){
+        return -1;
+    }
+    if(utc || len == 16){
+        return utcToEpoch(year, month, day, hour, min, sec);
+    }
+    struct tm st;
+    st.tm_year = year-1900;
+    st.tm_mon = month-1;
+    st.tm_mday = day;
+    st.tm_hour = hour;
+    st.tm_min = min;
+    st.tm_sec = sec;
+    st.tm_isdst = -1;
+    return mktime(&st);
+}
+
+//copy the value of the parameter 'name' from the ';'-separated parameter list 'params' into 'out' (without quotes)
+//returns false if the parameter is not present
+static bool findIcsParam(const char *params, const char *name, char *out, size_t len){
+    size_t nameLen = strlen(name);
+    while(*params != '\0'){
+        bool match = !strncasecmp(params, name, nameLen) && params[nameLen] == '=';
+        if(match){
+            params += nameLen+1;
+        }
+        size_t n = 0;
+        bool quoted = false;
+        for (; *params != '\0' && (quoted || *params != ';'); ++params) {
+            if(*params == '"'){
+                quoted = !quoted;
+            }else if(match && n < len-1){
+                out[n++] = *params;
+            }
+        }
+        if(match){
+            out[n] = '\0';
+            return true;
+        }
+        if(*params == ';'){
+            params++;
+        }
+    }
+    return false;
+}
+
+//check if the time zone identifier 'tzid' names UTC. other time zones can't be resolved without a time zone database
+static bool isUtcZone(const char *tzid){
+    return !strcasecmp(tzid, "UTC") || !strcasecmp(tzid, "GMT") || !strcasecmp(tzid, "Etc/UTC") ||
+           !strcasecmp(tzid, "Etc/GMT") || !strcasecmp(tzid, "Z");
+}
+
+//copy a TEXT value into 'out' and resolve its escape sequences. line breaks become spaces because
+//a description has to fit into a single line of the list file
+static void unescapeIcsText(const char *value, char *out, size_t len){
+    size_t n = 0;
+    for (size_t i = 0; value[i] != '\0' && n < len-1; ++i) {
+        char c = value[i];
+        if(c == '\\' && value[i+1] != '\0'){
+            c = value[++i];
+            if(c == 'n' || c == 'N'){
+                c = ' ';
+            }
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+}
+
+//import every VEVENT with a DTSTART from the iCalendar file 'filename' into 'list'.
+//the file is parsed while it is read, all imported appointments are added as a single version (undo removes the whole import).
+//in external-memory mode the appointments are sorted into runs instead, an IMPORTED entry added to the tree as the
+//new version makes them visible
+//the result of the import is stored in 'stats', returns false if the file couldn't be opened or memory, respectively
+//space for the runs, ran out. the appointments imported until then are kept and counted in 'stats->loaded'
+static bool importIcs(List *list, const char *filename, PlannerStats *stats){
+    memset(stats, 0, sizeof(PlannerStats));
+    IcsReader *reader = (IcsReader*) malloc(sizeof(IcsReader));
+    if(reader == NULL){
+        return false;
+    }
+    reader->file = fopen(filename, "rb");
+    if(reader->file == NULL){
+        stats->unreadable = true;
+        free(reader);
+        return false;
+    }
+    reader->pos = reader->len = 0;
+
+    time_t curr_time = time(NULL);
+    Node *root = retainNode(list->versions[list->current]);
+    unsigned long importId = list->nextId++; // the imported appointments get larger ids
+    if(list->store != NULL && !storeAddImport(list->store, importId)){
+        fclose(reader->file);
+        free(reader);
+        releaseNode(root);
+        return false;
+    }
+
+    char line[ICS_LINE_LENGTH];
+    char summary[PLANNER_DESCRIPTION_SIZE];
+    bool inEvent = false;
+    int nested = 0; // depth of components inside the current VEVENT (e.g. VALARM), their properties are ignored
+    time_t start = -1;
+    bool zoned = false; // DTSTART has a TZID which couldn't be resolved
+    bool ok = true;
+
+    while (ok && readIcsLine(reader, line, sizeof(line))){
+        //content line: name *(";" param) ":" value, the colon may also appear in quoted parameter values
+        char *value = line;
+        bool quoted = false;
+        while(*value != '\0' && (quoted || *value != ':')){
+            if(*value == '"'){
+                quoted = !quoted;
+            }
+            value++;
+        }
+        if(*value == '\0'){
+            continue;
+        }
+        *value++ = '\0';
+        char *params = strchr(line, ';');
+        if(params != NULL){
+            *params++ = '\0';
+        }
+
+        if(!strcmp(line, "BEGIN")){
+            if(inEvent){
+                nested++;
+            }else if(!strcmp(value, "VEVENT")){
+                inEvent = true;
+                start = -1;
+                zoned = false;
+                strcpy(summary, "(no summary)");
+            }
+        }else if(!strcmp(line, "END") && inEvent){
+            if(nested > 0){
+                nested--;
+            }else{
+                inEvent = false;
+                if(start == -1){
+                    stats->invalid++;
+                }else if(start > curr_time){
+                    if(list->store != NULL){
+                        ok = storeAdd(list->store, start, list->nextId++, summary);
+                    }else{
+                        ok = bulkInsert(list, &root, start, summary);
+                    }
+                    if(ok){
+                        stats->loaded++;
+                        if(zoned){
+                            stats->unresolvedZones++;
+                        }
+                    }
+                }else{
+                    stats->expired++;
+                }
+            }
+        }else if(inEvent && nested == 0){
+            if(!strcmp(line, "DTSTART")){
+                char tzid[64];
+                bool hasZone = params != NULL && findIcsParam(params, "TZID", tzid, sizeof(tzid));
+                start = parseIcsTime(value, hasZone && isUtcZone(tzid));
+                zoned = hasZone && !isUtcZone(tzid) && strchr(value, 'Z') == NULL;
+            }else if(!strcmp(line, "SUMMARY") && *value != '\0'){
+                unescapeIcsText(value, summary, sizeof(summary));
+            }
+        }
+    }
+    fclose(reader->file);
+    free(reader);
+
+    if(list->store != NULL && !spillRun(list->store)){
+        //the appointments still in the sort buffer are dropped, the runs only hold complete rows
+        stats->loaded -= list->store->recordCount;
+        list->store->recordCount = list->store->textUsed = 0;
+        ok = false;
+    }
+    if(list->store != NULL && stats->loaded > 0){
+        Appointment *imported = newAppointment(LONG_MIN, "", importId);
+        bool inserted = imported != NULL;
+        if(imported != NULL){
+            imported->kind = IMPORTED;
+            Node *next = treeInsert(root, imported, &inserted);
+            releaseAppointment(imported);
+            if(inserted){
+                releaseNode(root);
+                root = next;
+            }else{
+                releaseNode(next);
+            }
+        }
+        if(!inserted){
+            //without the entry the rows written to the runs stay hidden
+            stats->loaded = 0;
+            ok = false;
+        }
+    }
+    if(stats->loaded > 0){
+        commitVersion(list, root);
+    }else{
+        releaseNode(root);
+    }
+    return ok;
+}
+
+//write 'line' followed by CRLF, folding it into chunks of at most 75 octets (RFC 5545 3.1).
+//folds are never placed inside a multi-byte UTF-8 sequence
+static void writeIcsLine(FILE *file, const char *line){
+    size_t len = strlen(line);
+    size_t limit = 75;
+    while(len > limit){
+        size_t cut = limit;
+        while(cut > 1 && ((unsigned char) line[cut] & 0xC0) == 0x80){
+            cut--;
+        }
+        fwrite(line, 1, cut, file);
+        fputs("\r\n ", file);
+        line += cut;
+        len -= cut;
+        limit = 74; // the leading space of a continuation line counts towards its length
+    }
+    fputs(line, file);
+    fputs("\r\n", file);
+}
+
+//export the tree 'root' and the runs of 'store' (may be NULL) to the iCalendar file 'filename', every appointment
+//becomes a VEVENT. appointments are written while the tree is traversed, returns false if the file couldn't be written
+static bool exportIcs(RunStore *store, Node *root, const char *filename){
+    FILE *file = fopen(filename, "wb");
+    if(file == NULL){
+        return false;
+    }
+
+    char stamp[17];
+    struct tm utc;
+    time_t curr_time = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", gmtime_r(&curr_time, &utc));
+
+    writeIcsLine(file, "BEGIN:VCALENDAR");
+    writeIcsLine(file, "VERSION:2.0");
+    writeIcsLine(file, "PRODID:-//stellarwindDE//planner//EN");
+
+    Cursor cursor;
+    cursorSeek(&cursor, store, root, LONG_MIN);
+    Appointment *appointment;
+    char line[2*ICS_LINE_LENGTH];
+    unsigned long exported = 0; // appointments read from runs have no id, number them instead to get unique UIDs
+    while ((appointment = cursorNext(&cursor)) != NULL){
+        writeIcsLine(file, "BEGIN:VEVENT");
+        snprintf(line, sizeof(line), "UID:%ld-%lu@planner", appointment->start, exported++);
+        writeIcsLine(file, line);
+        snprintf(line, sizeof(line), "DTSTAMP:%s", stamp);
+        writeIcsLine(file, line);
+        strcpy(line, "DTSTART:");
+        strftime(line+8, sizeof(line)-8, "%Y%m%dT%H%M%SZ", gmtime_r(&appointment->start, &utc));
+        writeIcsLine(file, line);
+
+        //escape backslash, semicolon and comma in TEXT values, control characters (e.g. a stray '\r') are not allowed
+        size_t n = strlen("SUMMARY:");
+        strcpy(line, "SUMMARY:");
+        for (const char *c = appointment->description; *c != '\0' && n < sizeof(line)-2; ++c) {
+            if(iscntrl((unsigned char) *c)){
+                continue;
+            }
+            if(*c == '\\' || *c == ';' || *c == ','){
+                line[n++] = '\\';
+            }
+            line[n++] = *c;
+        }
+        line[n] = '\0';
+        writeIcsLine(file, line);
+        writeIcsLine(file, "END:VEVENT");
+    }
+
+    writeIcsLine(file, "END:VCALENDAR");
+    bool ok = !ferror(file);
+    if(fclose(file) != 0){
+        ok = false;
+    }
+    return ok;
+}
+
+//return the name of the sparse offset index belonging to 'filename' (filename + ".idx")
+//the returned string is allocated with malloc() and needs to be freed
+static char *indexFilename(const char *filename){
+    char *name = malloc(strlen(filename) + strlen(INDEX_SUFFIX) + 1);
+    if(name == NULL){
+        return NULL;
+    }
+    strcpy(name, filename);
+    strcat(name, INDEX_SUFFIX);
+    return name;
+}
+
+//append an index record for the line at 'offset' if it is the first line starting in a new page of the list file.
+//records have a fixed width so the index itself can be binary searched
+static void writeIndexEntry(FILE *index, long *lastPage, long offset, time_t start){
+    if(offset / INDEX_PAGE_SIZE > *lastPage){
+        *lastPage = offset / INDEX_PAGE_SIZE;
+        fprintf(index, "%020ld %020ld\n", start, offset);
+    }
+}
+
+//read a single line from 'file' into 'buffer', the rest of lines longer than the buffer is discarded
+//returns false at end of file
+static bool readLine(FILE *file, char *buffer, int len){
+    if(fgets(buffer, len, file) == NULL){
+        return false;
+    }
+    if(strchr(buffer, '\n') == NULL){
+        int c;
+        while((c = getc(file)) != '\n' && c != EOF){}
+    }
+    return true;
+}
+
+//create the sparse offset index for the list file 'filename'. saveList() keeps an existing index up to date
+//returns false if the file couldn't be read or is not sorted by start time
+bool plannerBuildIndex(const char *filename){
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL){
+        return false;
+    }
+    char *name = indexFilename(filename);
+    FILE *index = name != NULL ? fopen(name, "w") : NULL;
+    if(index == NULL){
+        free(name);
+        fclose(file);
+        return false;
+    }
+
+    bool sorted = true;
+    long lastPage = -1;
+    time_t previous = LONG_MIN;
+    char line[LINE_LENGTH];
+    long offset = ftell(file);
+    while (sorted && readLine(file, line, sizeof(line))){
+        long start;
+        if(sscanf(line, "%ld,", &start) == 1){
+            sorted = start >= previous;
+            previous = start;
+            writeIndexEntry(index, &lastPage, offset, start);
+        }
+        offset = ftell(file);
+    }
+    fclose(index);
+    fclose(file);
+
+    if(!sorted){
+        remove(name);
+    }
+    free(name);
+    return sorted;
+}
+
+//find the first readable line in 'file' which begins at or after byte 'pos' and store its start time in 'start'.
+//returns the offset of that line or 'end' if no such line begins before 'end'
+static long seekLine(FILE *file, long pos, long end, time_t *start){
+    char line[LINE_LENGTH];
+    if(pos > 0){
+        //pos is usually in the middle of a line, resynchronize on the next line break
+        fseek(file, pos-1, SEEK_SET);
+        int c;
+        while((c = getc(file)) != '\n' && c != EOF){}
+    }else{
+        fseek(file, 0, SEEK_SET);
+    }
+
+    long offset = ftell(file);
+    while(offset < end && readLine(file, line, sizeof(line))){
+        long parsed;
+        if(sscanf(line, "%ld,", &parsed) == 1){
+            *start = parsed;
+            return offset;
+        }
+        offset = ftell(file);
+    }
+    return end;
+}
+
+//check that the index record (start, offset) still describes a line of the list file
+static bool checkIndexEntry(FILE *file, long offset, time_t start){
+    time_t found;
+    return seekLine(file, offset, offset+1, &found) == offset && found == start;
+}
+
+//read record 'n' of the sparse offset index, returns false if it is damaged
+static bool readIndexEntry(FILE *index, long n, time_t *start, long *offset){
+    char record[INDEX_RECORD_LENGTH+1];
+    fseek(index, n * INDEX_RECORD_LENGTH, SEEK_SET);
+    if(fread(record, 1, INDEX_RECORD_LENGTH, index) != INDEX_RECORD_LENGTH){
+        return false;
+    }
+    record[INDEX_RECORD_LENGTH] = '\0';
+    return sscanf(record, "%ld %ld", start, offset) == 2;
+}
+
+//narrow the byte range [lo, hi] of the list file which contains the first line starting at or after 'from'
+//using the sparse offset index. the index is ignored if it is older than the list file or doesn't match it
+static void narrowWithIndex(const char *filename, FILE *file, time_t from, long *lo, long *hi){
+    char *name = indexFilename(filename);
+    if(name == NULL){
+        return;
+    }
+    struct stat dataStat, indexStat;
+    FILE *index = NULL;
+    if(stat(filename, &dataStat) == 0 && stat(name, &indexStat) == 0 && indexStat.st_mtime >= dataStat.st_mtime){
+        index = fopen(name, "rb");
+    }
+    free(name);
+    if(index == NULL){
+        return;
+    }
+
+    fseek(index, 0, SEEK_END);
+    long count = ftell(index) / INDEX_RECORD_LENGTH;
+
+    //binary search for the first record starting at or after 'from'
+    long first = 0, last = count;
+    bool intact = true;
+    while(intact && first < last){
+        long mid = first + (last-first)/2;
+        time_t start;
+        long offset;
+        intact = readIndexEntry(index, mid, &start, &offset);
+        if(!intact){
+            break;
+        }
+        if(start < from){
+            first = mid+1;
+        }else{
+            last = mid;
+        }
+    }
+
+    time_t start;
+    long offset, newLo = *lo, newHi = *hi;
+    if(intact && first > 0){
+        intact = readIndexEntry(index, first-1, &start, &offset) && checkIndexEntry(file, offset, start);
+        newLo = offset+1;
+    }
+    if(intact && first < count){
+        intact = readIndexEntry(index, first, &start, &offset) && checkIndexEntry(file, offset, start);
+        newHi = offset;
+    }
+    fclose(index);
+
+    if(intact && newLo <= newHi){
+        *lo = newLo;
+        *hi = newHi;
+    }
+}
+
+//binary search over the byte range [lo, hi] of a file sorted by start time (list file or run) for the first line
+//starting at or after 'from'. the file is positioned at that line afterwards and its offset is returned
+static long findFirstLine(FILE *file, long lo, long hi, time_t from){
+    //smallest position whose next line starts at or after 'from' (or doesn't exist)
+    time_t start;
+    while(lo < hi){
+        long mid = lo + (hi-lo)/2;
+        long offset = seekLine(file, mid, hi, &start);
+        if(offset < hi && start < from){
+            lo = offset+1;
+        }else{
+            hi = mid;
+        }
+    }
+    seekLine(file, lo, lo, &start);
+    return lo;
+}
+
+//create the state of the external-memory mode. at most 'memoryLimit' bytes are used for buffers:
+//one half is the sort buffer, the other half is split into the stdio buffers of the runs. returns NULL if malloc() failed
+static RunStore *createStore(size_t memoryLimit){
+    RunStore *store = (RunStore*) malloc(sizeof(RunStore));
+    if(store == NULL){
+        return NULL;
+    }
+    store->sortSize = memoryLimit / 2;
+    store->bufferSize = memoryLimit / 2 / (MAX_RUNS+1);
+    if(store->bufferSize < MIN_RUN_BUFFER){
+        store->bufferSize = MIN_RUN_BUFFER;
+    }
+    store->sortBuffer = malloc(store->sortSize);
+    store->pool = malloc(store->bufferSize * (MAX_RUNS+1));
+    if(store->sortBuffer == NULL || store->pool == NULL){
+        free(store->sortBuffer);
+        free(store->pool);
+        free(store);
+        return NULL;
+    }
+    store->recordCount = store->textUsed = 0;
+    store->runCount = 0;
+    store->imports = NULL;
+    store->importCount = store->importCapacity = 0;
+    for (int i = 0; i < MAX_RUNS+1; ++i) {
+        store->slotUsed[i] = false;
+    }
+    return store;
+}
+
+//close all runs and release the memory of 'store'
+static void freeStore(RunStore *store){
+    for (int i = 0; i < store->runCount; ++i) {
+        fclose(store->runs[i]);
+    }
+    free(store->sortBuffer);
+    free(store->pool);
+    free(store->imports);
+    free(store);
+}
+
+//remember that the following rows of the runs belong to the import 'id', returns false if malloc() failed
+static bool storeAddImport(RunStore *store, unsigned long id){
+    if(store->importCount == store->importCapacity){
+        size_t capacity = store->importCapacity == 0 ? 8 : store->importCapacity*2;
+        unsigned long *imports = realloc(store->imports, capacity * sizeof(unsigned long));
+        if(imports == NULL){
+            return false;
+        }
+        store->imports = imports;
+        store->importCapacity = capacity;
+    }
+    store->imports[store->importCount++] = id;
+    return true;
+}
+
+//create an empty temporary run which uses a free buffer of the pool, the run is deleted once it is closed.
+//returns NULL if the temporary file couldn't be created
+static FILE *newRun(RunStore *store, int *slot){
+    *slot = 0;
+    while(store->slotUsed[*slot]){
+        (*slot)++;
+    }
+    FILE *run = tmpfile();
+    if(run == NULL){
+        return NULL;
+    }
+    setvbuf(run, store->pool + *slot * store->bufferSize, _IOFBF, store->bufferSize);
+    store->slotUsed[*slot] = true;
+    return run;
+}
+
+//finish writing the new run 'run', returns false and deletes the run if it couldn't be written completely (e.g. disk full)
+static bool finishRun(RunStore *store, FILE *run, int slot){
+    if(fflush(run) != 0 || ferror(run)){
+        fclose(run);
+        store->slotUsed[slot] = false;
+        return false;
+    }
+    return true;
+}
+
+//merge the runs from index 'first' to the newest one into a single run of level 'level', which takes their place.
+//the runs are consecutive, so appointments with the same start time keep their order.
+//returns false if the merged run couldn't be written, the runs are left unchanged then
+static bool mergeRuns(RunStore *store, int first, int level){
+    int slot;
+    FILE *merged = newRun(store, &slot);
+    if(merged == NULL){
+        return false;
+    }
+
+    Cursor cursor;
+    iterSeek(&cursor.tree, NULL, LONG_MIN);
+    cursor.treeNext = NULL;
+    cursor.hiddenBelow = 0; // rows hidden in the visible version are kept for the older ones
+    cursor.store = NULL;
+    cursorSeekRuns(&cursor, store->runs+first, store->runCount-first, LONG_MIN);
+    unsigned long maxId = 0;
+    Appointment *appointment;
+    while ((appointment = cursorNext(&cursor)) != NULL){
+        fprintf(merged, "%ld,%lu,%s\n", appointment->start, appointment->id, appointment->description);
+        maxId = appointment->id > maxId ? appointment->id : maxId;
+    }
+    if(!finishRun(store, merged, slot)){
+        return false;
+    }
+
+    for (int i = first; i < store->runCount; ++i) {
+        fclose(store->runs[i]);
+        store->slotUsed[store->runSlots[i]] = false;
+    }
+    store->runs[first] = merged;
+    store->runSlots[first] = slot;
+    store->runLevels[first] = level;
+    store->runMaxIds[first] = maxId;
+    store->runCount = first+1;
+    return true;
+}
+
+//merge runs of similar size after a new run was added (size-tiered compaction): once the newest MERGE_FACTOR runs
+//have the same level, they become a single run of the next level. every appointment is rewritten about
+//log(spills)/log(MERGE_FACTOR) times, instead of once per spill when the whole store is merged each time.
+//with at most MERGE_FACTOR-1 runs per level MAX_RUNS is only reached after about MERGE_FACTOR^10 spills, all runs are merged then.
+//if a merge fails the runs stay as they are, spillRun() fails once MAX_RUNS is reached.
+//merging happens inline: spills only occur while loading (before other threads can see the calendar) and importing
+//(holding the lock), and readers of the runs hold the lock for the whole query since the runs share their file
+//positions and buffers. a merge in a worker thread would block them just as long
+static void compactRuns(RunStore *store){
+    int newest = store->runCount-1;
+    while(store->runCount >= MERGE_FACTOR && store->runLevels[newest-MERGE_FACTOR+1] == store->runLevels[newest]){
+        if(!mergeRuns(store, store->runCount-MERGE_FACTOR, store->runLevels[newest]+1)){
+            return;
+        }
+        newest = store->runCount-1;
+    }
+    if(store->runCount == MAX_RUNS){
+        mergeRuns(store, 0, store->runLevels[0]+1);
+    }
+}
+
+//order records by start time, records with the same start time keep the order in which they were added
+static int compareRecords(const void *a, const void *b){
+    const Record *ra = a, *rb = b;
+    if(ra->start != rb->start){
+        return ra->start < rb->start ? -1 : 1;
+    }
+    return ra->id < rb->id ? -1 : (ra->id > rb->id);
+}
+
+//sort the records in the sort buffer and write them to a new run. returns false if the run couldn't be written,
+//the records stay in the sort buffer then
+static bool spillRun(RunStore *store){
+    if(store->recordCount == 0){
+        return true;
+    }
+    if(store->runCount == MAX_RUNS){
+        return false;
+    }
+    Record *records = (Record*) store->sortBuffer;
+    qsort(records, store->recordCount, sizeof(Record), compareRecords);
+
+    int slot;
+    FILE *run = newRun(store, &slot);
+    if(run == NULL){
+        return false;
+    }
+    unsigned long maxId = 0;
+    for (size_t i = 0; i < store->recordCount; ++i) {
+        fprintf(run, "%ld,%lu,%s\n", records[i].start, records[i].id, store->sortBuffer + records[i].offset);
+        maxId = records[i].id > maxId ? records[i].id : maxId;
+    }
+    if(!finishRun(store, run, slot)){
+        return false;
+    }
+    store->runs[store->runCount] = run;
+    store->runSlots[store->runCount] = slot;
+    store->runMaxIds[store->runCount] = maxId;
+    store->runLevels[store->runCount++] = 0;
+    store->recordCount = store->textUsed = 0;
+    compactRuns(store);
+    return true;
+}
+
+//add an appointment to the sort buffer of 'store', the buffer is spilled to a new run once it is full.
+//records grow from the start of the buffer, their descriptions from its end. returns false if the buffer couldn't be spilled
+static bool storeAdd(RunStore *store, time_t start, unsigned long id, const char *description){
+    size_t len = strlen(description)+1;
+    if((store->recordCount+1) * sizeof(Record) + store->textUsed + len > store->sortSize){
+        if(!spillRun(store) || sizeof(Record) + len > store->sortSize){
+            return false;
+        }
+    }
+    store->textUsed += len;
+    size_t offset = store->sortSize - store->textUsed;
+    memcpy(store->sortBuffer + offset, description, len);
+    Record *records = (Record*) store->sortBuffer;
+    records[store->recordCount].start = start;
+    records[store->recordCount].id = id;
+    records[store->recordCount++].offset = offset;
+    return true;
+}
+
+//read the next row of a run into 'cursor->row', sets 'cursor->valid' to false at the end of the run
+static void runCursorAdvance(RunCursor *cursor){
+    cursor->valid = false;
+    while(readLine(cursor->file, cursor->line, sizeof(cursor->line))){
+        long start;
+        unsigned long id;
+        int length = 0;
+        if(sscanf(cursor->line, "%ld,%lu,%n", &start, &id, &length) == 2 && length > 0){
+            char *description = cursor->line + length;
+            description[strcspn(description, "\n")] = '\0';
+            cursor->row.start = start;
+            cursor->row.id = id;
+            cursor->row.description = description;
+            cursor->valid = true;
+            return;
+        }
+    }
+}
+
+//position 'cursor' in front of the first appointment starting at or after 'from' in the tree 'root' and
+//all runs of 'store' (which may be NULL). runs share their file position, so only one cursor may be used at a time
+static void cursorSeek(Cursor *cursor, RunStore *store, Node *root, time_t from){
+    iterSeek(&cursor->tree, root, from);
+    cursor->treeNext = iterNext(&cursor->tree);
+
+    //a CLEARED entry is the smallest entry of the tree, it hides all rows of older runs
+    Node *first = root;
+    while(first != NULL && first->left != NULL){
+        first = first->left;
+    }
+    cursor->hiddenBelow = first != NULL && first->appointment->kind == CLEARED ? first->appointment->id : 0;
+    cursor->store = store;
+    cursor->root = root;
+    FILE *runs[MAX_RUNS];
+    int count = 0;
+    for (int i = 0; store != NULL && i < store->runCount; ++i) {
+        if(store->runMaxIds[i] >= cursor->hiddenBelow){
+            runs[count++] = store->runs[i];
+        }
+    }
+    cursorSeekRuns(cursor, runs, count, from);
+}
+
+//position the run cursors of 'cursor' in front of the first appointment starting at or after 'from' in the 'count' runs
+static void cursorSeekRuns(Cursor *cursor, FILE **runs, int count, time_t from){
+    cursor->runCount = count;
+    for (int i = 0; i < count; ++i) {
+        RunCursor *run = &cursor->runs[i];
+        run->file = runs[i];
+        if(from == LONG_MIN){
+            fseek(run->file, 0, SEEK_SET);
+        }else{
+            fseek(run->file, 0, SEEK_END);
+            findFirstLine(run->file, 0, ftell(run->file), from);
+        }
+        runCursorAdvance(run);
+    }
+}
+
+//return the next appointment in ascending order from either the tree or one of the runs, NULL at the end.
+//rows of the runs hidden by a TOMBSTONE or CLEARED entry of the tree or whose import isn't part of the version are
+//skipped, the entries themselves as well.
+//appointments read from a run are only valid until the next call
+static Appointment *cursorNext(Cursor *cursor){
+    while(true){
+        RunCursor *next = NULL;
+        for (int i = 0; i < cursor->runCount; ++i) {
+            RunCursor *run = &cursor->runs[i];
+            while(run->valid && (run->row.id < cursor->hiddenBelow || !rowVisible(cursor, &run->row))){
+                runCursorAdvance(run);
+            }
+            if(run->valid && (next == NULL || compareAppointments(&run->row, &next->row) < 0)){
+                next = run;
+            }
+        }
+
+        Appointment *entry = cursor->treeNext;
+        if(entry != NULL && (next == NULL || compareAppointments(entry, &next->row) <= 0)){
+            cursor->treeNext = iterNext(&cursor->tree);
+            if(entry->kind == APPOINTMENT){
+                return entry;
+            }
+            if(entry->kind == TOMBSTONE && next != NULL && compareAppointments(entry, &next->row) == 0){
+                runCursorAdvance(next);
+            }
+            continue;
+        }
+        if(next == NULL){
+            return NULL;
+        }
+        cursor->current.start = next->row.start;
+        cursor->current.id = next->row.id;
+        cursor->current.refs = 0; // not owned by any tree
+        cursor->current.kind = APPOINTMENT;
+        strcpy(cursor->description, next->row.description);
+        cursor->current.description = cursor->description;
+        runCursorAdvance(next);
+        return &cursor->current;
+    }
+}
+
+//check whether the run row 'row' was loaded from the list file or belongs to an import with an IMPORTED entry in the tree
+static bool rowVisible(Cursor *cursor, Appointment *row){
+    RunStore *store = cursor->store;
+    if(store == NULL || store->importCount == 0 || row->id < store->imports[0]){
+        return true;
+    }
+    //the import of the row is the last one with a smaller id
+    size_t lo = 0, hi = store->importCount;
+    while(hi - lo > 1){
+        size_t mid = lo + (hi-lo)/2;
+        if(store->imports[mid] < row->id){
+            lo = mid;
+        }else{
+            hi = mid;
+        }
+    }
+    Appointment key = {.start = LONG_MIN, .id = store->imports[lo]};
+    return treeContains(cursor->root, &key);
+}
+
+//check whether the tree 'root' holds an entry with the start time and id of 'key'
+static bool treeContains(Node *root, Appointment *key){
+    while(root != NULL){
+        int cmp = compareAppointments(key, root->appointment);
+        if(cmp == 0){
+            return true;
+        }
+        root = cmp < 0 ? root->left : root->right;
+    }
+    return false;
+}
+
+//find the first appointment with the given start time and description in the tree 'root' and the runs of 'store'.
+//returns NULL if there is none, the result is either part of the tree or 'cursor->current' for a run row
+static Appointment *cursorFind(Cursor *cursor, RunStore *store, Node *root, time_t start, const char *description){
+    cursorSeek(cursor, store, root, start);
+    Appointment *appointment;
+    while ((appointment = cursorNext(cursor)) != NULL && appointment->start == start){
+        if(!strcmp(appointment->description, description)){
+            return appointment;
+        }
+    }
+    return NULL;
+}
+
+// empty the provided list. the previous version remains available to undoList()
+// in external-memory mode the tree is replaced by a CLEARED entry which hides every row of the runs.
+// returns false if memory ran out
+static bool clearList(List *list){
+    if(list->store == NULL){
+        if(list->versions[list->current] != NULL){
+            commitVersion(list, NULL);
+        }
+        return true;
+    }
+    Cursor cursor;
+    cursorSeek(&cursor, list->store, list->versions[list->current], LONG_MIN);
+    if(cursorNext(&cursor) == NULL){
+        return true;
+    }
+    Appointment *cleared = newAppointment(LONG_MIN, "", list->nextId++);
+    if(cleared == NULL){
+        return false;
+    }
+    cleared->kind = CLEARED;
+    bool ok = true;
+    Node *root = makeNode(cleared, NULL, NULL, &ok);
+    releaseAppointment(cleared);
+    if(ok){
+        commitVersion(list, root);
+    }
+    return ok;
+}
+
+// release every version of the provided list and the allocated memory of all included items
+static void freeList(List *list){
+    for (size_t i = 0; list->versions != NULL && i < list->count; ++i) {
+        releaseNode(list->versions[i]);
+    }
+    free(list->versions);
+    list->versions = NULL;
+    if(list->store != NULL){
+        freeStore(list->store);
+        list->store = NULL;
+    }
+    list->count = list->current = 0;
+}
+
+//turn every character in the provided string into its lowercase version
+static void toLowercase(char* str){
+    size_t n = 0;
+    while (str[n] != '\0'){
+        str[n] = tolower(str[n]);
+        n++;
+    }
+}
+
+//find the first appointment in the tree 'root' or the runs of 'store' whose description matches 'query'(case-insensitive)
+//returns a pointer to the appointment or NULL if no matching appointment was found.
+//the pointer stays valid as long as 'root' is retained, appointments read from a run of the external-memory mode
+//are only valid until 'cursor' is used again
+static Appointment *findAppointment(RunStore *store, Node *root, const char* query, Cursor *cursor){
+    int size = strlen(query);
+    char tmp[size+1];
+    strncpy(tmp, query, size+1);
+    toLowercase(tmp);
+    char desc[PLANNER_DESCRIPTION_SIZE];
+    cursorSeek(cursor, store, root, LONG_MIN);
+    Appointment *appointment;
+    while ((appointment = cursorNext(cursor)) != NULL)
+    {
+        strncpy(desc, appointment->description, strlen(appointment->description)+1);
+        toLowercase(desc);
+        if(strstr(desc, tmp) != NULL){
+            return appointment;
+        }
+    }
+    return NULL;
+}
+
+//copy 'appointment' into the caller-owned 'out'
+static void copyAppointment(PlannerAppointment *out, Appointment *appointment){
+    out->start = appointment->start;
+    out->id = appointment->id;
+    strncpy(out->description, appointment->description, PLANNER_DESCRIPTION_SIZE-1);
+    out->description[PLANNER_DESCRIPTION_SIZE-1] = '\0';
+}
+
+//a calendar is a list guarded by a lock. every change happens while holding the lock, readers only hold it to
+//retain and release a snapshot of the visible version (see beginRead())
+struct Calendar
+{
+    pthread_mutex_t lock;
+    List list;
+};
+
+//start reading 'calendar' and return the root of the visible version.
+//nodes of the persistent tree never change, so in-memory calendars are traversed without holding the lock.
+//the runs of the external-memory mode share their file positions, they are read while holding the lock
+static Node *beginRead(Calendar *calendar){
+    pthread_mutex_lock(&calendar->lock);
+    Node *root = snapshotList(&calendar->list);
+    if(calendar->list.store == NULL){
+        pthread_mutex_unlock(&calendar->lock);
+    }
+    return root;
+}
+
+//finish a read started with beginRead()
+static void endRead(Calendar *calendar, Node *root){
+    if(calendar->list.store == NULL){
+        pthread_mutex_lock(&calendar->lock);
+    }
+    releaseNode(root); // reference counts are only modified while holding the lock
+    pthread_mutex_unlock(&calendar->lock);
+}
+
+Calendar *plannerOpen(const char *filename, size_t memoryLimit, PlannerStats *stats){
+    PlannerStats ignored;
+    if(stats == NULL){
+        stats = &ignored;
+    }
+    memset(stats, 0, sizeof(PlannerStats));
+    Calendar *calendar = (Calendar*) malloc(sizeof(Calendar));
+    if(calendar == NULL){
+        return NULL;
+    }
+    if(filename != NULL){
+        calendar->list = readList(filename, memoryLimit, stats);
+    }else{
+        calendar->list = createList();
+        if(calendar->list.versions != NULL && memoryLimit > 0){
+            calendar->list.store = createStore(memoryLimit);
+            if(calendar->list.store == NULL){
+                freeList(&calendar->list);
+            }
+        }
+    }
+    if(calendar->list.versions == NULL || pthread_mutex_init(&calendar->lock, NULL) != 0){
+        freeList(&calendar->list);
+        free(calendar);
+        return NULL;
+    }
+    return calendar;
+}
+
+void plannerClose(Calendar *calendar){
+    if(calendar != NULL){
+        pthread_mutex_destroy(&calendar->lock);
+        freeList(&calendar->list);
+        free(calendar);
+    }
+}
+
+bool plannerSave(Calendar *calendar, const char *filename){
+    Node *root = beginRead(calendar);
+    bool ok = saveList(calendar->list.store, root, filename);
+    endRead(calendar, root);
+    return ok;
+}
+
+bool plannerIsExternal(Calendar *calendar){
+    return calendar->list.store != NULL;
+}
+
+//copy the description of 'appointment' into 'out' so it fits into a single row of the list file:
+//it is cut after PLANNER_DESCRIPTION_SIZE-1 characters and line breaks are replaced by spaces
+static void copyDescription(char *out, const PlannerAppointment *appointment){
+    size_t n = 0;
+    for (; n < PLANNER_DESCRIPTION_SIZE-1 && appointment->description[n] != '\0'; ++n) {
+        char c = appointment->description[n];
+        out[n] = c == '\r' || c == '\n' ? ' ' : c;
+    }
+    out[n] = '\0';
+}
+
+size_t plannerInsertMany(Calendar *calendar, const PlannerAppointment *appointments, size_t count){
+    pthread_mutex_lock(&calendar->lock);
+    List *list = &calendar->list;
+    Node *root = retainNode(list->versions[list->current]);
+    size_t inserted = 0;
+    char description[PLANNER_DESCRIPTION_SIZE];
+    for (size_t i = 0; i < count; ++i) {
+        copyDescription(description, &appointments[i]);
+        if(!bulkInsert(list, &root, appointments[i].start, description)){
+            break;
+        }
+        inserted++;
+    }
+    if(inserted > 0){
+        commitVersion(list, root);
+    }else{
+        releaseNode(root);
+    }
+    pthread_mutex_unlock(&calendar->lock);
+    return inserted;
+}
+
+size_t plannerDeleteMany(Calendar *calendar, const PlannerAppointment *appointments, size_t count){
+    pthread_mutex_lock(&calendar->lock);
+    List *list = &calendar->list;
+    Node *root = retainNode(list->versions[list->current]);
+    size_t deleted = 0;
+    bool ok = true;
+    Cursor cursor;
+    for (size_t i = 0; i < count; ++i) {
+        Appointment *toDelete = cursorFind(&cursor, list->store, root, appointments[i].start, appointments[i].description);
+        if(toDelete == &cursor.current){
+            //the row is kept on disk by the external-memory mode, hide it with a tombstone
+            Appointment *tombstone = newAppointment(toDelete->start, "", toDelete->id);
+            if(tombstone == NULL){
+                break;
+            }
+            tombstone->kind = TOMBSTONE;
+            Node *next = treeInsert(root, tombstone, &ok);
+            releaseAppointment(tombstone);
+            if(!ok){
+                releaseNode(next);
+                break;
+            }
+            releaseNode(root);
+            root = next;
+            deleted++;
+        }else if(toDelete != NULL){
+            bool removed = false;
+            Node *next = treeRemove(root, toDelete, &removed, &ok);
+            if(!ok){
+                releaseNode(next);
+                break;
+            }
+            releaseNode(root);
+            root = next;
+            deleted++;
+        }
+    }
+    if(deleted > 0){
+        commitVersion(list, root);
+    }else{
+        releaseNode(root);
+    }
+    pthread_mutex_unlock(&calendar->lock);
+    return deleted;
+}
+
+bool plannerClear(Calendar *calendar){
+    pthread_mutex_lock(&calendar->lock);
+    bool ok = clearList(&calendar->list);
+    pthread_mutex_unlock(&calendar->lock);
+    return ok;
+}
+
+bool plannerUndo(Calendar *calendar){
+    pthread_mutex_lock(&calendar->lock);
+    bool done = undoList(&calendar->list);
+    pthread_mutex_unlock(&calendar->lock);
+    return done;
+}
+
+bool plannerRedo(Calendar *calendar){
+    pthread_mutex_lock(&calendar->lock);
+    bool done = redoList(&calendar->list);
+    pthread_mutex_unlock(&calendar->lock);
+    return done;
+}
+
+//count the nodes of the tree 'node'
+static size_t countNodes(Node *node){
+    return node == NULL ? 0 : 1 + countNodes(node->left) + countNodes(node->right);
+}
+
+//check if 'node' is part of the tree 'root'. a node shared with 'root' is found on the search path of its appointment
+static bool containsNode(Node *root, Node *node){
+    while(root != NULL && root != node){
+        int cmp = compareAppointments(node->appointment, root->appointment);
+        if(cmp == 0){
+            return false;
+        }
+        root = cmp < 0 ? root->left : root->right;
+    }
+    return root != NULL;
+}
+
+//count the nodes of the tree 'node' which are not shared with the tree 'previous'.
+//the subtree of a shared node is shared as a whole, since nodes never change
+static size_t countCreated(Node *node, Node *previous){
+    if(node == NULL || containsNode(previous, node)){
+        return 0;
+    }
+    return 1 + countCreated(node->left, previous) + countCreated(node->right, previous);
+}
+
+void plannerVersionStats(Calendar *calendar, PlannerVersionStats *stats){
+    pthread_mutex_lock(&calendar->lock);
+    List *list = &calendar->list;
+    Node *root = list->versions[list->current];
+    stats->nodes = countNodes(root);
+    stats->created = countCreated(root, list->current > 0 ? list->versions[list->current-1] : NULL);
+    stats->nodeSize = sizeof(Node);
+    pthread_mutex_unlock(&calendar->lock);
+}
+
+size_t plannerQueryRange(Calendar *calendar, time_t from, time_t to, const PlannerAppointment *after, PlannerAppointment *out, size_t capacity){
+    //keyset paging: resume at the start time of 'after' and skip the appointments up to and including it
+    Appointment last = {.start = LONG_MIN};
+    if(after != NULL){
+        last.start = after->start;
+        last.id = after->id;
+        from = after->start > from ? after->start : from;
+    }
+    Node *root = beginRead(calendar);
+    Cursor cursor;
+    cursorSeek(&cursor, calendar->list.store, root, from);
+    size_t copied = 0;
+    Appointment *appointment;
+    while (copied < capacity && (appointment = cursorNext(&cursor)) != NULL && appointment->start <= to){
+        if(after == NULL || compareAppointments(appointment, &last) > 0){
+            copyAppointment(&out[copied++], appointment);
+        }
+    }
+    endRead(calendar, root);
+    return copied;
+}
+
+bool plannerSearch(Calendar *calendar, const char *query, PlannerAppointment *result){
+    Node *root = beginRead(calendar);
+    Cursor cursor;
+    Appointment *appointment = findAppointment(calendar->list.store, root, query, &cursor);
+    if(appointment != NULL){
+        copyAppointment(result, appointment);
+    }
+    endRead(calendar, root);
+    return appointment != NULL;
+}
+
+bool plannerImportIcs(Calendar *calendar, const char *filename, PlannerStats *stats){
+    PlannerStats ignored;
+    pthread_mutex_lock(&calendar->lock);
+    bool ok = importIcs(&calendar->list, filename, stats != NULL ? stats : &ignored);
+    pthread_mutex_unlock(&calendar->lock);
+    return ok;
+}
+
+bool plannerExportIcs(Calendar *calendar, const char *filename){
+    Node *root = beginRead(calendar);
+    bool ok = exportIcs(calendar->list.store, root, filename);
+    endRead(calendar, root);
+    return ok;
+}
+
+//the list file is sorted by start time (see saveList()), so the first appointment of the range is found with a
+//binary search over byte offsets, only the lines of the range are read afterwards
+long plannerQueryFileRange(const char *filename, time_t from, time_t to, size_t skip, PlannerAppointment *out, size_t capacity){
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL){
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long lo = 0, hi = ftell(file);
+    narrowWithIndex(filename, file, from, &lo, &hi);
+    findFirstLine(file, lo, hi, from);
+
+    long copied = 0;
+    char line[LINE_LENGTH];
+    while((size_t) copied < capacity && readLine(file, line, sizeof(line))){
+        long start;
+        char *comma = strchr(line, ',');
+        if(comma == NULL || sscanf(line, "%ld,", &start) != 1){
+            continue;
+        }
+        if(start > to){
+            break;
+        }
+        if(skip > 0){
+            skip--;
+            continue;
+        }
+        comma[strcspn(comma, "\n")] = '\0';
+        Appointment appointment = {.start = start, .description = comma+1};
+        copyAppointment(&out[copied++], &appointment);
+    }
+    fclose(file);
+    return copied;
+}
@@ -0,0 +1,102 @@
+//
+// Embeddable calendar library used by the planner CLI.
+// Every function is reentrant, a calendar may be shared between threads: changes are serialized by a lock
+// of the calendar, in-memory calendars are read from an immutable snapshot without blocking writers.
+// The library never prints or exits, failures (memory exhausted, temporary files not writable) are reported by the
+// return values below.
+//
+
+#ifndef PLANNER_LIBPLANNER_H
+#define PLANNER_LIBPLANNER_H
+
+#include <time.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PLANNER_DESCRIPTION_SIZE 305 // buffer size of a description, see plannerInsertMany()
+
+//opaque handle of a calendar
+typedef struct Calendar Calendar;
+
+//an appointment as it is passed into and returned from the library (caller-owned buffers)
+typedef struct
+{
+    time_t start;
+    char description[PLANNER_DESCRIPTION_SIZE];
+    unsigned long id; // set by queries, orders appointments with the same start time. ignored when inserting
+} PlannerAppointment;
+
+//result of loading or importing a file
+typedef struct
+{
+    int loaded;      // appointments added to the calendar
+    int expired;     // appointments skipped because they already started
+    int invalid;     // damaged lines or events without a valid start time
+    int unresolvedZones; // imported events whose start time has a time zone (TZID) other than UTC, read as local time
+    bool unreadable; // the file couldn't be opened
+} PlannerStats;
+
+//memory used by the visible version of a calendar, see plannerVersionStats()
+typedef struct
+{
+    size_t nodes;    // tree nodes of the version, a full copy of the list would allocate this many nodes
+    size_t created;  // nodes allocated by the change which produced the version, all others are shared with the previous one
+    size_t nodeSize; // bytes allocated per node (descriptions are shared by all versions and not counted)
+} PlannerVersionStats;
+
+//open the list file 'filename' (may be NULL for an empty calendar), appointments which already started are skipped.
+//if 'memoryLimit' is not 0, the external-memory mode is used: the appointments of the file stay on disk and
+//at most 'memoryLimit' bytes are used for buffers. the limit only covers the appointments of the file and of imports:
+//appointments created with plannerInsertMany(), deletions and deleteall of appointments kept on disk and the versions
+//kept for undo are held in memory in addition, e.g. deleting n appointments of the file uses memory proportional to n
+//until the calendar is saved and opened again. 'stats' may be NULL. the calendar has to be closed with plannerClose().
+//rows with a description longer than PLANNER_DESCRIPTION_SIZE-1 characters count as invalid.
+//returns NULL if memory ran out or the runs of the external-memory mode couldn't be written, a missing file is only
+//reported in 'stats'
+Calendar *plannerOpen(const char *filename, size_t memoryLimit, PlannerStats *stats);
+void plannerClose(Calendar *calendar);
+//write all appointments sorted by start time to the list file 'filename', nothing is written for an empty calendar
+bool plannerSave(Calendar *calendar, const char *filename);
+bool plannerIsExternal(Calendar *calendar);
+
+//insert 'count' appointments as a single change, returns the number of inserted appointments.
+//every appointment becomes one row of the list file: descriptions are cut after PLANNER_DESCRIPTION_SIZE-1 characters
+//(the buffer doesn't have to be terminated then) and line breaks ('\r', '\n') are replaced by spaces.
+//a short count means memory ran out, the appointments before it were inserted
+size_t plannerInsertMany(Calendar *calendar, const PlannerAppointment *appointments, size_t count);
+//delete one appointment matching start and description for each of the 'count' entries as a single change.
+//returns the number of deleted appointments, deleting stops early if memory ran out
+size_t plannerDeleteMany(Calendar *calendar, const PlannerAppointment *appointments, size_t count);
+//delete all appointments as a single change, returns false if memory ran out
+bool plannerClear(Calendar *calendar);
+//revert or restore changes, returns false if there is nothing to undo/redo
+bool plannerUndo(Calendar *calendar);
+bool plannerRedo(Calendar *calendar);
+//measure the structure shared between the visible version and the one before it, takes time linear in the size of
+//the calendar. meant for benchmarks (see bench_versions.c)
+void plannerVersionStats(Calendar *calendar, PlannerVersionStats *stats);
+
+//copy the appointments starting in [from, to] into 'out' in ascending order of start time and id. if 'after' is not NULL,
+//only appointments behind it are copied. returns the number of copied appointments, if it equals 'capacity' the next page
+//is queried with 'after' set to the last copied appointment.
+//every page is read from a consistent snapshot. the position of the next page doesn't depend on the previous snapshot,
+//so while other threads change the calendar between pages, appointments present during the whole listing are returned
+//exactly once and appointments inserted or deleted meanwhile may or may not be returned
+size_t plannerQueryRange(Calendar *calendar, time_t from, time_t to, const PlannerAppointment *after, PlannerAppointment *out, size_t capacity);
+//find the first appointment whose description contains 'query' (case-insensitive), returns false if there is none
+bool plannerSearch(Calendar *calendar, const char *query, PlannerAppointment *result);
+
+//import the VEVENTs of the iCalendar file 'filename' as a single change. returns false if the file couldn't be read
+//('stats->unreadable') or memory respectively space for temporary files ran out, the 'stats->loaded' appointments
+//imported until then are kept.
+//start times with a TZID other than UTC are read as local time and counted in 'stats->unresolvedZones'
+bool plannerImportIcs(Calendar *calendar, const char *filename, PlannerStats *stats);
+bool plannerExportIcs(Calendar *calendar, const char *filename);
+
+//like plannerQueryRange() but works on the list file 'filename' directly without loading it, using a binary search
+//and the sparse offset index if present. returns -1 if the file couldn't be read
+long plannerQueryFileRange(const char *filename, time_t from, time_t to, size_t skip, PlannerAppointment *out, size_t capacity);
+//create the sparse offset index of the list file 'filename', returns false if the file couldn't be read or is not sorted
+bool plannerBuildIndex(const char *filename);
+
+#endif //PLANNER_LIBPLANNER_H
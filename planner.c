@@ -5,6 +5,10 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdint.h>
+#include "libplanner.h"
 
 bool isNumber(char* str);
 bool containsNegative(int n, ...);
@@ -16,208 +20,62 @@ time_t inputTime(bool dateOnly);
 
 #define MAX_INPUT_LENGTH 255
 #define TIME_COMPONENTS 6
-
-typedef struct
-{
-    time_t start;
-    char *description;
-} Appointment;
-
-typedef struct Element
-{
-    Appointment *appointment;
-    struct Element *next;
-} Element;
-
-typedef struct
-{
-    Element *head, *tail;
-} List;
-
-List createList();
-void clearList(List list);
-void insertAppointment(List list, time_t start, const char* description);
-Element *findElement(List list, const char* query);
-bool deleteElement(List list, const char* query);
-void printAppointment(Appointment *toPrint);
-void printList(List list, int day, int month, int year);
-
-void displayListEpoch(List list, time_t time);
-void saveList(List list, char *filename);
-List readList(char *filename);
-Appointment* newAppointment(time_t start, const char *description);
-void logMallocErr();
-void toLowercase(char* str);
+#define LIST_PAGE_SIZE 64 // appointments fetched from the calendar at once while printing
+
+void printAppointment(PlannerAppointment *toPrint);
+void nextPage(PlannerAppointment *page, size_t count, time_t *from, size_t *skip);
+void printList(Calendar *calendar, int day, int month, int year);
+void displayListEpoch(Calendar *calendar, time_t time);
+bool queryDay(char *filename, char *date);
+void printStats(char *filename, PlannerStats *stats);
+void printUsage(char *program);
 void clearStdin();
 void readFromStdin(char* buffer, int len);
-void menu(List list);
-
-//log an error to stderr after malloc failed to allocate new memory
-void logMallocErr(){
-    fprintf(stderr, "FATAL ERROR: memory exhausted, malloc() failed.\n");
-}
-
-//create a new appointment starting at the given time 'start'
-//allocate memory for the structure & description usinc malloc() and return a pointer to said structure
-Appointment* newAppointment(time_t start, const char *description){
-    Appointment *appointment = (Appointment*) malloc(sizeof(Appointment));
-    if(appointment == NULL){
-        logMallocErr();
-        return NULL;
-    }
-    appointment->start = start;
-    appointment->description = malloc(strlen(description)+1);
-    if(appointment->description == NULL){
-        logMallocErr();
-        return NULL;
-    }
-    strncpy(appointment->description, description, strlen(description)+1);
+void menu(Calendar *calendar);
 
-    return appointment;
+//prints all appointments to console which satisfy the following criteria:
+// - the start time of the appointment is on the same day as the provided argument time
+void displayListEpoch(Calendar *calendar, time_t time){
+    struct tm now;
+    localtime_r(&time, &now);
+    printList(calendar, now.tm_mday, now.tm_mon+1, now.tm_year+1900);
 }
 
-//create & return an empty list
-List createList(){
-    List list;
-    Element *head = malloc (sizeof (Element));
-    Element *tail = malloc (sizeof (Element));
-    if(head == NULL || tail == NULL){
-        logMallocErr();
-        exit(EXIT_FAILURE);
-    }
-    head->appointment = tail->appointment = NULL;
-    head->next = tail->next = tail;
-    list.head = head;
-    list.tail = tail;
-
-    return list;
+//prints information of the given appointment to stdout in a single line
+void printAppointment(PlannerAppointment *toPrint){
+    struct tm now;
+    localtime_r(&(toPrint->start), &now);
+    printf("%04d-%02d-%02d %02d:%02d:%02d // Description: %s\n", now.tm_year+1900, now.tm_mon+1, now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec, toPrint->description);
 }
 
-//create a new appointment and insert it at the appropriate position in the given list
-void insertAppointment(List list, time_t start, const char *description){
-    Appointment* appointment = newAppointment(start, description);
-    Element *element = (Element*) malloc(sizeof(Element));
-    if(element == NULL){
-        logMallocErr();
+//advance the position of a paged query of the list file behind the 'count' appointments of 'page'.
+//the next page starts at the start time of the last appointment, skipping those already returned with that start time
+void nextPage(PlannerAppointment *page, size_t count, time_t *from, size_t *skip){
+    if(count == 0){
         return;
     }
-    element->appointment = appointment;
-
-    if(list.head->next == list.tail){
-        element->next = list.tail;
-        list.head->next = element;
-    }else{
-        Element *current = list.head->next;
-        Element *previous = list.head;
-        while(current->appointment != NULL && appointment->start > current->appointment->start){
-            previous = current;
-            current = current->next;
-        }
-        element->next = current;
-        previous->next = element;
+    time_t last = page[count-1].start;
+    if(last != *from){
+        *from = last;
+        *skip = 0;
     }
-}
-
-// Function to save the list to a CSV file
-void saveList(List list, char *filename){
-    if(list.head->next != list.tail){
-        FILE *file = fopen(filename, "w");
-
-        Element *current = list.head->next;
-        while (current->appointment != NULL){
-            //y2k38-bug possible depending on data model and size of time_t.. %ld should be replaced with %lld
-            fprintf(file, "%ld,%s\n", current->appointment->start, current->appointment->description);
-
-            current = current->next;
+    for (size_t i = 0; i < count; ++i) {
+        if(page[i].start == last){
+            (*skip)++;
         }
-        fclose(file);
     }
 }
 
-// Function to read the appointment list from file
-List readList(char *filename){
-    List list = createList();
-    time_t curr_time = time(NULL);
-
-    int appointments_skipped = 0;
-    bool file_damaged = false;
-
-    FILE *file = fopen(filename, "r");
-
-    if(file != NULL){
-        char line[MAX_INPUT_LENGTH+50];
-        while (fgets(line, sizeof(line), file) != NULL){
-            long start;
-            char description[256];
-            //y2k38-bug possible depending on data model and size of time_t %ld should be replaced with %lld(+ l.150: long long start;)
-            if(sscanf(line, "%ld,%[^\n]", &start, description) == 2){ // Check if sscanf was able to read both parameters from the line, ignore the line otherwise
-                if(start > curr_time){
-                    Appointment *appointment = newAppointment(start, description);
-                    if(appointment != NULL){
-                        insertAppointment(list, start, description);
-                    }
-                }else{
-                    appointments_skipped++;
-                }
-            }else{
-                file_damaged = true;
-            }
-        }
-
-        fclose(file);
-    }else{
-        fprintf(stderr, "ERROR: %s couldn't be read. Does the file exist?\n", filename);
-    }
-
-    // Display some status information
-    if (appointments_skipped > 0)
-        printf("] Skipped %d appointments because they expired.\n", appointments_skipped);
-    if (file_damaged)
-        printf("] The file %s seems to be damaged, some data might not be available as expected.\n Before issuing the command 'quit', make sure to create a copy of said file.\nUpon issuing the command, all data that couldn't be read will be lost.\n", filename);
-
-    return list;
-}
-
-// empty the provided list and release the allocated memory of all included items
-void clearList(List list){
-    if(list.head->next != list.tail){
-        Element *current = list.head->next;
-        while (current->appointment != NULL){
-            Element *next = current->next;
-
-            free(current->appointment->description);
-            free(current->appointment);
-            free(current);
-
-            current = next;
-        }
-        list.head->next = list.tail;
-    }
-}
-
-//prints all appointments to console which satisfy the following criteria:
-// - the start time of the appointment is on the same day as the provided argument time
-void displayListEpoch(List list, time_t time){
-    struct tm* now = localtime(&time);
-    printList(list, now->tm_mday, now->tm_mon+1, now->tm_year+1900);
-}
-
-//prints information of the given appointment to stdout in a single line
-void printAppointment(Appointment *toPrint){
-    struct tm* now = localtime(&(toPrint->start));
-    printf("%04d-%02d-%02d %02d:%02d:%02d // Description: %s\n", now->tm_year+1900, now->tm_mon+1, now->tm_mday, now->tm_hour, now->tm_min, now->tm_sec, toPrint->description);
-}
-
-/* Function to display the appointments in the given list:
- * if all 3 integer arguments are set to zero, list every appointment in the list
+/* Function to display the appointments in the given calendar:
+ * if all 3 integer arguments are set to zero, list every appointment in the calendar
  * otherwise, print only those appointments, which happen to have their start time on the provided day.
- * (all elements in the provided list have to be sorted by start time of appointment in ascending order)*/
-void printList(List list, int day, int month, int year){
+ * (appointments are fetched page by page with plannerQueryRange(), each page resumes behind the last printed one)*/
+void printList(Calendar *calendar, int day, int month, int year){
     bool printAll = day == 0 && month == 0 && year == 0;
     bool appointmentFound = false;
 
     struct tm st;
-    time_t time;
+    time_t time = LONG_MIN, end = LONG_MAX;
     if(!printAll) {
         st.tm_year = year-1900;
         st.tm_mon = month-1;
@@ -225,101 +83,109 @@ void printList(List list, int day, int month, int year){
         st.tm_isdst = -1;
         st.tm_sec = st.tm_min = st.tm_hour = 0;
         time = mktime(&st);
+        end = time+86400; // 60s -> 60min -> 24h => 86400s in 1d
     }
 
-    if(list.head->next == list.tail){
+    PlannerAppointment page[LIST_PAGE_SIZE];
+    if(plannerQueryRange(calendar, LONG_MIN, LONG_MAX, NULL, page, 1) == 0){
         printf("] List of appointments is empty.\n");
-    }else{
-        Element *current = list.head->next;
-
-        while (current->appointment != NULL){
-            Appointment *appointment = current->appointment;
-
-            // Check if the appointment should be printed
-            bool print = false;
-            if (printAll){
-                print = true; // If all the parameters are 0, print the entire list
-            }else if(appointment->start >= time){
-                if(appointment->start <= time+86400){ // 60s -> 60min -> 24h => 86400s in 1d
-                    print = true;
-                }else{
-                    break;
-                }
-            }
-
-            if (print){
-                if(!printAll && !appointmentFound){
-                    printf("] Listing appointments on %04d-%02d-%02d:\n", year, month, day);
-                    appointmentFound = true;
-                }
-                printf("----\n");
-                printAppointment(appointment);
-            }
+        return;
+    }
 
-            current = current->next;
+    PlannerAppointment last;
+    size_t count;
+    bool first = true;
+    do {
+        count = plannerQueryRange(calendar, time, end, first ? NULL : &last, page, LIST_PAGE_SIZE);
+        first = false;
+        if(count > 0){
+            last = page[count-1];
         }
-        if(!appointmentFound && !printAll){
-            printf("] No appointment was found on %04d-%02d-%02d.\n", year, month, day);
-            return;
+        for (size_t i = 0; i < count; ++i) {
+            if(!printAll && !appointmentFound){
+                printf("] Listing appointments on %04d-%02d-%02d:\n", year, month, day);
+                appointmentFound = true;
+            }
+            printf("----\n");
+            printAppointment(&page[i]);
         }
+    } while (count == LIST_PAGE_SIZE);
+
+    if(!appointmentFound && !printAll){
+        printf("] No appointment was found on %04d-%02d-%02d.\n", year, month, day);
+    }else{
         printf("----\n");
     }
 }
 
-//turn every character in the provided string into its lowercase version
-void toLowercase(char* str){
-    size_t n = 0;
-    while (str[n] != '\0'){
-        str[n] = tolower(str[n]);
-        n++;
+//print the appointments of the day 'date' (yyyy-mm-dd) from the list file 'filename' without loading the list,
+//see plannerQueryFileRange(). the output matches printList(). returns false if the date or file is invalid
+bool queryDay(char *filename, char *date){
+    char input[MAX_INPUT_LENGTH];
+    strncpy(input, date, MAX_INPUT_LENGTH-1);
+    input[MAX_INPUT_LENGTH-1] = '\0';
+    struct tm *day = parse_time(input, true);
+    if(day == NULL){
+        return false;
     }
-}
+    if(!isValidDate(day)){
+        fprintf(stderr, "ERROR: Invalid date, expected yyyy-mm-dd\n");
+        free(day);
+        return false;
+    }
+    time_t from = mktime(day);
+    int year = day->tm_year+1900, month = day->tm_mon+1, mday = day->tm_mday;
+    free(day);
 
-//find the first element in 'list' whose appointment description matches 'query'(case-insensitive)
-//returns a pointer to the element or NULL if no matching element was found in 'list'
-Element *findElement(List list, const char* query){
-    if(list.head->next != list.tail){
-        int size = strlen(query);
-        char tmp[size+1];
-        strncpy(tmp, query, size);
-        toLowercase(tmp);
-        char desc[MAX_INPUT_LENGTH];
-        Element *current = list.head->next;
-        while (current->appointment != NULL)
-        {
-            strncpy(desc, current->appointment->description, strlen(current->appointment->description)+1);
-            toLowercase(desc);
-            if(strstr(desc, tmp) != NULL){
-                return current;
+    //expired appointments are skipped like when the file is loaded
+    time_t curr_time = time(NULL);
+    bool appointmentFound = false;
+    PlannerAppointment page[LIST_PAGE_SIZE];
+    time_t next = from;
+    size_t skip = 0;
+    long count;
+    do {
+        count = plannerQueryFileRange(filename, next, from+86400, skip, page, LIST_PAGE_SIZE);
+        if(count < 0){
+            fprintf(stderr, "ERROR: %s couldn't be read. Does the file exist?\n", filename);
+            return false;
+        }
+        nextPage(page, count, &next, &skip);
+        for (long i = 0; i < count; ++i) {
+            if(page[i].start <= curr_time){
+                continue;
+            }
+            if(!appointmentFound){
+                printf("] Listing appointments on %04d-%02d-%02d:\n", year, month, mday);
+                appointmentFound = true;
             }
-            current = current->next;
+            printf("----\n");
+            printAppointment(&page[i]);
         }
+    } while (count == LIST_PAGE_SIZE);
+
+    if(appointmentFound){
+        printf("----\n");
+    }else{
+        printf("] No appointment was found on %04d-%02d-%02d.\n", year, month, mday);
     }
-    return NULL;
+    return true;
 }
 
-//use findElement() with the provided arguments to find a matching element in 'list'
-//if found, remove the element from 'list' and free associated memory then return true
-//otherwise, return false
-bool deleteElement(List list, const char* query){
-    Element *toDelete = findElement(list, query);
-    bool found = (toDelete != NULL);
-    bool listNotEmpty = (list.head->next != list.tail);
-
-    if(found && listNotEmpty){
-        Element *current = list.head->next;
-        while (current->appointment != NULL){
-            if(current->next == toDelete){
-                current->next = toDelete->next;
-                free(toDelete->appointment->description);
-                free(toDelete->appointment);
-                free(toDelete);
-                return true;
-            }
-            current = current->next;
-        }
-    }
-    return false;
+//display the result of loading or importing 'filename'
+void printStats(char *filename, PlannerStats *stats){
+    if (stats->unreadable)
+        fprintf(stderr, "ERROR: %s couldn't be read. Does the file exist?\n", filename);
+    if (stats->expired > 0)
+        printf("] Skipped %d appointments because they expired.\n", stats->expired);
+}
+
+//print the supported command line arguments to stderr
+void printUsage(char *program){
+    fprintf(stderr, "Usage: %s [file]                  interactive mode (file defaults to termine.txt)\n", program);
+    fprintf(stderr, "       %s --max-memory MiB [file] interactive mode, the appointments of the file stay on disk\n", program);
+    fprintf(stderr, "       %s --query-day yyyy-mm-dd [file]\n", program);
+    fprintf(stderr, "       %s --build-index file\n", program);
 }
 
 //'flush' the input buffer
@@ -343,8 +209,8 @@ void readFromStdin(char* buffer, int len){
     }
 }
 
-//start an interactive prompt in the console, allowing someone to manipulate 'list' via text commands
-void menu(List list){
+//start an interactive prompt in the console, allowing someone to manipulate 'calendar' via text commands
+void menu(Calendar *calendar){
     char input[MAX_INPUT_LENGTH];
 
     // Loop until the user quits
@@ -357,14 +223,20 @@ void menu(List list){
             printf("] Starting appointment creation\n");
             time_t appTime = inputTime(false);
             printf("] Entered date: %s] Please enter a short description for your appointment: \n>", ctime(&appTime));
-            readFromStdin(input, MAX_INPUT_LENGTH);
-            insertAppointment(list, appTime, input);
+            PlannerAppointment appointment = {.start = appTime};
+            readFromStdin(appointment.description, MAX_INPUT_LENGTH);
+            if(plannerInsertMany(calendar, &appointment, 1) != 1){
+                fprintf(stderr, "ERROR: memory exhausted, the appointment couldn't be created.\n");
+            }
         } else if (!strcmp(input, "deleteall") || !strcmp(input, "3")) {
             printf("] Are you sure you want to delete all appointments? (y/n):");
             char c;
             if((c = getchar()) == 'y' || c == 'Y'){
-                clearList(list);
-                printf("] Cleared all appointments!\n");
+                if(plannerClear(calendar)){
+                    printf("] Cleared all appointments! ('undo' restores them)\n");
+                }else{
+                    fprintf(stderr, "ERROR: memory exhausted, the appointments couldn't be deleted.\n");
+                }
             }else{
                 printf("] Operation aborted!\n");
             }
@@ -373,9 +245,9 @@ void menu(List list){
             printf("] Please enter your search term:\n>");
             readFromStdin(input, MAX_INPUT_LENGTH);
             printf("] Searching.. ");
-            Element* ref = findElement(list, input);
-            if(ref != NULL){
-                printf(" Found!\n] Date: %s] Description: %s\n", ctime(&(ref->appointment->start)), ref->appointment->description);
+            PlannerAppointment ref;
+            if(plannerSearch(calendar, input, &ref)){
+                printf(" Found!\n] Date: %s] Description: %s\n", ctime(&(ref.start)), ref.description);
             }else{
                 printf(" Exhausted!\n] No appointment in the list matches your query\n");
                 continue;
@@ -384,7 +256,11 @@ void menu(List list){
             char c;
             if((c = getchar()) == 'y' || c == 'Y'){
 
-                printf(deleteElement(list, input) ? "] Deletion complete\n" : "] Deletion unsuccessful\n");
+                if(plannerDeleteMany(calendar, &ref, 1) == 1){
+                    printf("] Deletion complete\n");
+                }else{
+                    printf("] Deletion unsuccessful\n");
+                }
             }else{
                 printf("] Deletion aborted\n");
             }
@@ -393,18 +269,45 @@ void menu(List list){
             printf("] Please enter your search term:\n>");
             readFromStdin(input, MAX_INPUT_LENGTH);
             printf("] Searching.. ");
-            Element* ref = findElement(list, input);
-            if(ref != NULL){
-                printf(" Found!\n] Date: %s] Description: %s\n", ctime(&(ref->appointment->start)), ref->appointment->description);
+            PlannerAppointment ref;
+            if(plannerSearch(calendar, input, &ref)){
+                printf(" Found!\n] Date: %s] Description: %s\n", ctime(&(ref.start)), ref.description);
             }else{
                 printf(" Exhausted!\n  No appointment in the list matches your query\n");
             }
         } else if (!strcmp(input, "listtoday") || !strcmp(input, "7")) {
-            displayListEpoch(list, time(NULL));
+            displayListEpoch(calendar, time(NULL));
         } else if (!strcmp(input, "listday") || !strcmp(input, "6")) {
-            displayListEpoch(list, inputTime(true));
+            displayListEpoch(calendar, inputTime(true));
         } else if (!strcmp(input, "list") || !strcmp(input, "5")) {
-            printList(list, 0, 0, 0);
+            printList(calendar, 0, 0, 0);
+        } else if (!strcmp(input, "undo") || !strcmp(input, "9")) {
+            printf(plannerUndo(calendar) ? "] Undid the last change\n" : "] Nothing to undo\n");
+        } else if (!strcmp(input, "redo") || !strcmp(input, "10")) {
+            printf(plannerRedo(calendar) ? "] Restored the undone change\n" : "] Nothing to redo\n");
+        } else if (!strcmp(input, "import") || !strcmp(input, "11")) {
+            printf("] Please enter the path of the iCalendar (.ics) file to import:\n>");
+            readFromStdin(input, MAX_INPUT_LENGTH);
+            PlannerStats stats;
+            bool imported = plannerImportIcs(calendar, input, &stats);
+            printStats(input, &stats);
+            if (stats.invalid > 0)
+                printf("] Skipped %d events without a valid start time.\n", stats.invalid);
+            if (stats.unresolvedZones > 0)
+                fprintf(stderr, "WARNING: %d events use a time zone (TZID) that can't be resolved, their start times were read as local time and might be off by several hours.\n", stats.unresolvedZones);
+            if(imported){
+                printf("] Imported %d appointments ('undo' reverts the import)\n", stats.loaded);
+            }else if(!stats.unreadable){
+                fprintf(stderr, "ERROR: the import stopped early, memory or space for temporary files exhausted. %d appointments were imported.\n", stats.loaded);
+            }
+        } else if (!strcmp(input, "export") || !strcmp(input, "12")) {
+            printf("] Please enter the path of the iCalendar (.ics) file to create:\n>");
+            readFromStdin(input, MAX_INPUT_LENGTH);
+            if(plannerExportIcs(calendar, input)){
+                printf("] Export complete\n");
+            }else{
+                fprintf(stderr, "ERROR: writing %s failed.\n", input);
+            }
         } else if (!strcmp(input, "quit") || !strcmp(input, "0")) {
             printf("] Exiting program\n");
             return;
@@ -419,6 +322,10 @@ void menu(List list){
             printf("] (6) listday - list appointments on a specific date  \n");
             printf("] (7) listtoday - list all appointments planned for today \n");
             printf("] (8) menu - show this menu\n");
+            printf("] (9) undo - revert the last change  \n");
+            printf("] (10) redo - restore the last undone change  \n");
+            printf("] (11) import - import appointments from an iCalendar (.ics) file  \n");
+            printf("] (12) export - export all appointments to an iCalendar (.ics) file  \n");
         } else {
             fprintf(stderr, "ERROR: Unrecognized command\n");
         }
@@ -428,21 +335,83 @@ void menu(List list){
 
 int main(int argc, char** argv) {
   char* filename;
-  if (argc < 2) { // Check if a filename was passed as a parameter
+  // non-interactive fast paths, these work on the file directly without loading the list
+  if (argc >= 2 && !strcmp(argv[1], "--query-day")) {
+    if (argc < 3 || argc > 4) {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    return queryDay(argc > 3 ? argv[3] : "termine.txt", argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  if (argc >= 2 && !strcmp(argv[1], "--build-index")) {
+    if (argc != 3) {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    filename = argv[2];
+    if (!plannerBuildIndex(filename)) {
+      fprintf(stderr, "ERROR: the index for %s couldn't be created. Does the file exist and is it sorted by start time?\n", filename);
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  // --max-memory <MiB> keeps the appointments of the file on disk and uses at most the given amount of memory for buffers
+  size_t memoryLimit = 0;
+  int arg = 1;
+  if (argc >= 2 && !strcmp(argv[1], "--max-memory")) {
+    // only plain positive numbers, strtoul() would also accept a sign (e.g. "-1" as ULONG_MAX)
+    if (argc < 3 || argc > 4 || !isdigit((unsigned char) argv[2][0])) {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    char *end;
+    errno = 0;
+    unsigned long mib = strtoul(argv[2], &end, 10);
+    if (*end != '\0' || mib == 0) {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    if (errno == ERANGE || mib > SIZE_MAX / (1024 * 1024)) {
+      fprintf(stderr, "ERROR: --max-memory %s MiB is too large\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+    memoryLimit = (size_t) mib * 1024 * 1024;
+    printf("] External-memory mode, using at most %s MiB for buffers\n", argv[2]);
+    arg = 3;
+  }
+
+  if (argc > arg+1 || (argc > arg && !strncmp(argv[arg], "--", 2))) { // unknown option or too many arguments
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (argc <= arg) { // Check if a filename was passed as a parameter
     printf("] No filename provided, using 'termine.txt'\n");
     filename = "termine.txt";
   }else{
-    filename = argv[1];
+    filename = argv[arg];
   }
 
-  List l = readList(filename);
-  displayListEpoch(l, time(NULL));
-  menu(l);
-
-  saveList(l, filename);
-  clearList(l);
-  free(l.tail);
-  free(l.head);
+  PlannerStats stats;
+  Calendar *calendar = plannerOpen(filename, memoryLimit, &stats);
+  if (calendar == NULL) {
+    fprintf(stderr, "FATAL ERROR: %s couldn't be loaded, memory or space for temporary files exhausted.\n", filename);
+    return EXIT_FAILURE;
+  }
+  // Display some status information
+  printStats(filename, &stats);
+  if (stats.invalid > 0)
+    printf("] The file %s seems to be damaged, some data might not be available as expected.\n Before issuing the command 'quit', make sure to create a copy of said file.\nUpon issuing the command, all data that couldn't be read will be lost.\n", filename);
+
+  displayListEpoch(calendar, time(NULL));
+  menu(calendar);
+
+  bool saved = plannerSave(calendar, filename);
+  plannerClose(calendar);
+  if (!saved) {
+    fprintf(stderr, "ERROR: %s couldn't be written, the changes are lost.\n", filename);
+    return EXIT_FAILURE;
+  }
 
   return 0;
 }
@@ -518,15 +487,16 @@ int convertStrWithCheck(char* toConvert){
 struct tm* parse_time(char* in, bool dateOnly){
     struct tm* time = (struct tm*) malloc(sizeof(struct tm));
     if(time == NULL){
-        logMallocErr();
+        fprintf(stderr, "FATAL ERROR: memory exhausted, malloc() failed.\n");
         return NULL;
     }
     int components[TIME_COMPONENTS];
     char* delimiter = "-: \n";
-    components[0] = convertStrWithCheck(strtok(in, delimiter));
+    char* rest;
+    components[0] = convertStrWithCheck(strtok_r(in, delimiter, &rest));
 
     for (int i = 1; i < TIME_COMPONENTS; ++i) {
-        components[i] = convertStrWithCheck(strtok(NULL, delimiter));
+        components[i] = convertStrWithCheck(strtok_r(NULL, delimiter, &rest));
     }
 
     //perform sanity checks on entered Date: